@@ -59,6 +59,8 @@ endmacro()
 # Declares options for the project.
 macro(TYVI_DECLARE_OPTIONS)
     option(tyvi_ENABLE_COVERAGE "Enable coverage reporting" OFF)
+    option(tyvi_ENABLE_INSTRUMENTATION "Record timings of mdgrid_work operations" OFF)
+    option(tyvi_ENABLE_PERF_COUNTERS "Sample hardware counters around mdgrid_work operations" OFF)
 
     # cmake-lint: disable=C0103
     set(tyvi_BACKEND
@@ -136,6 +138,8 @@ macro(TYVI_DECLARE_OPTIONS)
             tyvi_ENABLE_CLANG_TIDY
             tyvi_ENABLE_CPPCHECK
             tyvi_ENABLE_COVERAGE
+            tyvi_ENABLE_INSTRUMENTATION
+            tyvi_ENABLE_PERF_COUNTERS
             tyvi_ENABLE_CACHE
         )
     endif()
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory_resource>
+#include <mutex>
+
+#include "tyvi/actions_ast.h"
+
+namespace tyvi::actions {
+
+/// Monotonic memory resource for cons cells of one list construction or evaluation.
+///
+/// Cells are bump allocated and deallocation is a no-op,
+/// all memory is released at once when the arena is destroyed.
+/// So cells allocated from the arena must not outlive it.
+///
+/// Allocation is thread safe, as continuations of eval might run on different threads.
+///
+/// Usage:
+///
+/// \code{.cpp}
+/// auto arena = node_arena{};
+/// const auto _ = node_resource_scope(&arena);
+/// // Cells created here and in eval continuations started here are allocated from arena.
+/// \endcode
+class node_arena final : public std::pmr::memory_resource {
+    std::mutex mutex_;
+    std::pmr::monotonic_buffer_resource buffer_;
+    std::atomic<std::size_t> allocated_bytes_{ 0 };
+
+    auto do_allocate(const std::size_t bytes, const std::size_t alignment) -> void* override {
+        allocated_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+        [[maybe_unused]]
+        const std::scoped_lock _{ mutex_ };
+        return buffer_.allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void*, std::size_t, std::size_t) override {}
+
+    [[nodiscard]]
+    auto do_is_equal(const std::pmr::memory_resource& other) const noexcept -> bool override {
+        return this == &other;
+    }
+
+  public:
+    static constexpr auto default_initial_size = 64uz * 1024uz;
+
+    explicit node_arena(const std::size_t initial_size = default_initial_size)
+        : node_arena(initial_size, std::pmr::get_default_resource()) {}
+
+    node_arena(const std::size_t initial_size, std::pmr::memory_resource* const upstream)
+        : buffer_(initial_size, upstream) {}
+
+    node_arena(const node_arena&)            = delete;
+    node_arena& operator=(const node_arena&) = delete;
+    node_arena(node_arena&&)                 = delete;
+    node_arena& operator=(node_arena&&)      = delete;
+    ~node_arena() override                   = default;
+
+    /// Total bytes handed out by the arena, including ones already deallocated.
+    [[nodiscard]]
+    auto allocated_bytes() const noexcept -> std::size_t {
+        return allocated_bytes_.load(std::memory_order_relaxed);
+    }
+};
+
+} // namespace tyvi::actions
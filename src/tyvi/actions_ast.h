@@ -1,10 +1,15 @@
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <concepts>
+#include <cstddef>
 #include <functional>
 #include <memory>
+#include <memory_resource>
 #include <optional>
 #include <print>
+#include <ranges>
 #include <stdexcept>
 #include <type_traits>
 #include <typeinfo>
@@ -13,6 +18,7 @@
 #include <vector>
 
 #include "tyvi/execution.h"
+#include "tyvi/sstd.h"
 
 namespace tyvi::sstd {
 
@@ -32,6 +38,10 @@ using null_type    = std::monostate;
 using sexpr        = std::variant<null_type, cons, atom>;
 using sexpr_sender = exec::unique_any_sender<sexpr>;
 using procedure    = std::function<exec::unique_any_sender<sexpr>(sexpr)>;
+/// Procedure which computes its value inline, without any asynchrony.
+///
+/// eval calls these directly and does not create senders for them.
+using sync_procedure = std::function<sexpr(sexpr)>;
 
 enum class intrinsic : std::uint8_t { car, cdr, quote };
 
@@ -48,17 +58,103 @@ concept sexpr_like = std::same_as<std::decay_t<T>, null_type> or std::same_as<st
 template<typename T>
 concept not_sexpr_like = (not sexpr_like<T>);
 
+namespace detail {
+
+/// Type dependent operations of an atom.
+///
+/// There is one static instance per stored type and storage kind,
+/// so an atom only has to hold a single pointer to it.
+struct atom_vtable {
+    /// Only used for heap stored values, inline values are trivially destructible.
+    void (*destroy)(void*);
+    /// Only used for heap stored values, inline values are copied bytewise.
+    void* (*clone)(void const*);
+    bool (*equal)(void const*, void const*);
+    std::size_t (*hash)(void const*);
+    std::type_info const* type_info;
+    bool is_inline;
+};
+
+/// Values which are not equality comparable (e.g. procedure) compare by identity.
+template<typename T>
+constexpr auto
+atom_value_equal(void const* const lhs_ptr, void const* const rhs_ptr) -> bool {
+    if constexpr (std::equality_comparable<T>) {
+        const auto& lhs = *static_cast<T const*>(lhs_ptr);
+        const auto& rhs = *static_cast<T const*>(rhs_ptr);
+        return lhs == rhs;
+    } else {
+        return lhs_ptr == rhs_ptr;
+    }
+}
+
+/// Values which are not hashable hash only by their type, which is consistent with equality.
+template<typename T>
+auto
+atom_value_hash(void const* const ptr) -> std::size_t {
+    if constexpr (std::is_default_constructible_v<std::hash<T>>) {
+        return std::hash<T>{}(*static_cast<T const*>(ptr));
+    } else {
+        return 0uz;
+    }
+}
+
+template<typename T>
+inline constexpr auto heap_atom_vtable = atom_vtable{
+    .destroy =
+        [](void* const ptr) {
+            // NOLINTBEGIN{cppcoreguidelines-owning-memory}
+            delete static_cast<T*>(ptr);
+            // NOLINTEND{cppcoreguidelines-owning-memory}
+        },
+    .clone =
+        [](void const* const src_ptr) {
+            const auto& src = *static_cast<T const*>(src_ptr);
+            return static_cast<void*>(new T{ src });
+        },
+    .equal     = &atom_value_equal<T>,
+    .hash      = &atom_value_hash<T>,
+    .type_info = &typeid(T),
+    .is_inline = false
+};
+
+template<typename T>
+inline constexpr auto inline_atom_vtable = atom_vtable{ .destroy   = nullptr,
+                                                        .clone     = nullptr,
+                                                        .equal     = &atom_value_equal<T>,
+                                                        .hash      = &atom_value_hash<T>,
+                                                        .type_info = &typeid(T),
+                                                        .is_inline = true };
+
+} // namespace detail
+
 class [[nodiscard]] atom {
-    /// FIXME: refactor to smart pointers
-    void* value_ptr_{ nullptr };
-    void (*value_deleter_)(void*){ nullptr };
-    bool (*comparison_op_)(void const*, void const*){ nullptr };
-    void* (*clone_op_)(void const*){ nullptr };
-    std::type_info const* value_type_info_{ nullptr };
+    static constexpr auto inline_size      = 2uz * sizeof(void*);
+    static constexpr auto inline_alignment = alignof(void*);
+
+    /// Small trivially copyable values are stored inside the atom at runtime.
+    ///
+    /// During constant evaluation everything is heap allocated,
+    /// as the inline buffer can not be reinterpreted there.
+    template<typename T>
+    static constexpr bool stored_inline = std::is_trivially_copyable_v<T>
+                                          and sizeof(T) <= inline_size
+                                          and alignof(T) <= inline_alignment;
+
+    union storage {
+        void* heap_ptr{ nullptr };
+        alignas(inline_alignment) std::array<std::byte, inline_size> buffer;
+    };
+
+    storage storage_{};
+    /// Null only in moved-from state.
+    detail::atom_vtable const* vtable_{ nullptr };
 
     [[nodiscard]]
     constexpr auto no_null_members_() const -> bool;
-    constexpr void set_null_();
+
+    [[nodiscard]]
+    constexpr auto value_ptr_() const -> void const*;
 
     constexpr atom() = default;
 
@@ -72,116 +168,208 @@ class [[nodiscard]] atom {
 
     constexpr ~atom();
 
+    /// Returns pointer to the stored value or nullptr if it is not of type T.
     template<typename T>
-    friend constexpr auto atom_cast(const atom&) -> std::optional<T>;
+    friend constexpr auto atom_get_if(const atom&) -> T const*;
 
-    friend constexpr auto operator==(const atom&, const atom&) -> bool;
+    /// Only accepts exact atoms, so that comparing e.g. two procedures
+    /// does not implicitly convert them to atoms and recurse.
+    template<std::same_as<atom> A>
+    friend constexpr auto operator==(const A&, const A&) -> bool;
 
     friend constexpr void swap(atom& lhs, atom& rhs) noexcept;
 
+    /// Hash consistent with operator==.
+    friend auto hash_value(const atom&) -> std::size_t;
+
+    /// Type of the stored value, which is typeid(void) for moved-from atoms.
+    friend auto atom_type(const atom&) -> const std::type_info&;
+
     template<typename T, typename... U>
     friend constexpr auto atom_is_of_type(const atom&) -> bool;
 };
 
-class [[nodiscard]] cons {
-    using sexpr_holder = std::unique_ptr<sexpr>;
+namespace detail {
 
-    // class invariant: car_ and cdr_ always point to valid sexprs.
+struct cons_node;
 
-    sexpr_holder car_{ new sexpr{} };
-    sexpr_holder cdr_{ new sexpr{} };
+/// nullptr means global operator new.
+inline thread_local std::pmr::memory_resource* current_node_resource = nullptr;
 
-    [[nodiscard]]
-    constexpr auto any_null_members_() const;
+} // namespace detail
+
+/// Memory resource used for cons cells created by the calling thread.
+///
+/// nullptr means that cells are allocated with global operator new.
+[[nodiscard]]
+inline auto
+node_resource() noexcept -> std::pmr::memory_resource* {
+    return detail::current_node_resource;
+}
+
+/// Binds memory resource for cons cells created by the calling thread during its lifetime.
+///
+/// Cells remember the resource they were allocated from,
+/// so they can be released after the scope has ended, as long as the resource is alive.
+class [[nodiscard]] node_resource_scope : sstd::immovable {
+    std::pmr::memory_resource* previous_;
+
+  public:
+    explicit node_resource_scope(std::pmr::memory_resource* const resource) noexcept
+        : previous_{ std::exchange(detail::current_node_resource, resource) } {}
+
+    ~node_resource_scope() { detail::current_node_resource = previous_; }
+};
+
+/// Immutable cons cell.
+///
+/// Cells are reference counted and never modified after construction,
+/// so copies are O(1) and share their structure with the original.
+class [[nodiscard]] cons {
+    // class invariant: node_ is null only in moved-from state.
+    detail::cons_node* node_{ nullptr };
+
+    constexpr void release_() noexcept;
 
   public:
     template<typename T, typename U>
     constexpr cons(T&& car, U&& cdr);
 
-    constexpr cons()  = default;
-    constexpr ~cons() = default;
-    constexpr cons(const cons&);
-    constexpr cons(cons&&) noexcept = default;
-    constexpr auto operator=(const cons&) -> cons&;
-    constexpr auto operator=(cons&&) noexcept -> cons& = default;
+    constexpr cons();
+    constexpr ~cons();
+    constexpr cons(const cons&) noexcept;
+    constexpr cons(cons&&) noexcept;
+    constexpr auto operator=(const cons&) noexcept -> cons&;
+    constexpr auto operator=(cons&&) noexcept -> cons&;
 
     [[nodiscard]]
     constexpr auto car() const -> const sexpr&;
     [[nodiscard]]
     constexpr auto cdr() const -> const sexpr&;
 
-    /// Deep equality comparison.
+    /// Deep equality comparison, which is O(1) for shared cells.
+    ///
+    /// Outside of constant evaluation cells with different structural hashes
+    /// compare unequal without walking the structure.
     friend constexpr auto operator==(const cons&, const cons&) -> bool;
 
-    /// Appends two lists togethera.
-    friend struct list_append_closure;
+    /// Structural hash consistent with operator==.
+    ///
+    /// Computed on first use and cached in the cell.
+    friend auto hash_value(const cons&) -> std::size_t;
 };
 
+namespace detail {
+
+struct cons_node {
+    sexpr car;
+    sexpr cdr;
+    /// Only accessed through std::atomic_ref outside of constant evaluation.
+    alignas(std::atomic_ref<std::size_t>::required_alignment) std::size_t refs{ 1 };
+    /// Resource the node was allocated from or nullptr for global operator new.
+    std::pmr::memory_resource* resource{ nullptr };
+    /// Zero if not yet computed. Only accessed through std::atomic_ref.
+    alignas(std::atomic_ref<std::size_t>::required_alignment) std::size_t hash{ 0 };
+};
+
+[[nodiscard]]
+constexpr auto
+make_cons_node(sexpr car, sexpr cdr) -> cons_node* {
+    if !consteval {
+        if (const auto r = current_node_resource) {
+            auto* const ptr = r->allocate(sizeof(cons_node), alignof(cons_node));
+            return ::new (ptr) cons_node{ .car      = std::move(car),
+                                          .cdr      = std::move(cdr),
+                                          .refs     = 1,
+                                          .resource = r,
+                                          .hash     = 0 };
+        }
+    }
+
+    // NOLINTNEXTLINE{cppcoreguidelines-owning-memory}
+    return new cons_node{ .car = std::move(car), .cdr = std::move(cdr) };
+}
+
+constexpr void
+destroy_cons_node(cons_node* const node) noexcept {
+    if !consteval {
+        if (const auto r = node->resource) {
+            std::destroy_at(node);
+            r->deallocate(node, sizeof(cons_node), alignof(cons_node));
+            return;
+        }
+    }
+
+    // NOLINTNEXTLINE{cppcoreguidelines-owning-memory}
+    delete node;
+}
+
+} // namespace detail
+
 // Implementations:
 
+template<std::same_as<atom> A>
 constexpr auto
-operator==(const atom& lhs, const atom& rhs) -> bool {
+operator==(const A& lhs, const A& rhs) -> bool {
     if (lhs.no_null_members_() and rhs.no_null_members_()
-        and (lhs.value_type_info_ == rhs.value_type_info_)) {
-        return (*lhs.comparison_op_)(lhs.value_ptr_, rhs.value_ptr_);
+        and (*lhs.vtable_->type_info == *rhs.vtable_->type_info)) {
+        return (*lhs.vtable_->equal)(lhs.value_ptr_(), rhs.value_ptr_());
     }
     return false;
 }
 
 template<not_sexpr_like T>
-constexpr atom::atom(T&& value)
-    : // NOLINTBEGIN{cppcoreguidelines-pro-bounds-array-to-pointer-decay,hicpp-no-array-decay}
-      value_ptr_{ static_cast<void*>(new std::decay_t<T>{ std::forward<T>(value) }) },
-      // NOLINTEND{cppcoreguidelines-pro-bounds-array-to-pointer-decay,hicpp-no-array-decay}
-      value_deleter_{ [](void* const ptr) {
-          // NOLINTBEGIN{cppcoreguidelines-owning-memory}
-          delete static_cast<std::decay_t<T>* const>(ptr);
-          // NOLINTEND{cppcoreguidelines-owning-memory}
-      } },
-      comparison_op_{ [](void const* const lhs_ptr, void const* const rhs_ptr) {
-          using ptr_type  = std::decay_t<T> const* const;
-          const auto& lhs = *static_cast<ptr_type>(lhs_ptr);
-          const auto& rhs = *static_cast<ptr_type>(rhs_ptr);
-          return lhs == rhs;
-      } },
-      clone_op_{ [](void const* const src_ptr) {
-          const auto& src = *static_cast<std::decay_t<T> const* const>(src_ptr);
-          return static_cast<void*>(new std::decay_t<T>{ src });
-      } },
-      value_type_info_{ &typeid(std::decay_t<T>) } {}
+constexpr atom::atom(T&& value) {
+    using value_type = std::decay_t<T>;
+
+    if consteval {
+        // NOLINTBEGIN{cppcoreguidelines-pro-bounds-array-to-pointer-decay,hicpp-no-array-decay}
+        storage_.heap_ptr = static_cast<void*>(new value_type{ std::forward<T>(value) });
+        // NOLINTEND{cppcoreguidelines-pro-bounds-array-to-pointer-decay,hicpp-no-array-decay}
+        vtable_ = &detail::heap_atom_vtable<value_type>;
+    } else {
+        if constexpr (stored_inline<value_type>) {
+            storage_.buffer = {};
+            // NOLINTBEGIN{cppcoreguidelines-pro-bounds-array-to-pointer-decay,hicpp-no-array-decay}
+            std::construct_at(reinterpret_cast<value_type*>(storage_.buffer.data()),
+                              std::forward<T>(value));
+            // NOLINTEND{cppcoreguidelines-pro-bounds-array-to-pointer-decay,hicpp-no-array-decay}
+            vtable_ = &detail::inline_atom_vtable<value_type>;
+        } else {
+            // NOLINTBEGIN{cppcoreguidelines-pro-bounds-array-to-pointer-decay,hicpp-no-array-decay}
+            storage_.heap_ptr = static_cast<void*>(new value_type{ std::forward<T>(value) });
+            // NOLINTEND{cppcoreguidelines-pro-bounds-array-to-pointer-decay,hicpp-no-array-decay}
+            vtable_ = &detail::heap_atom_vtable<value_type>;
+        }
+    }
+}
 
 constexpr auto
 atom::no_null_members_() const -> bool {
-    return std::invoke([]<typename... T>(T... p) static { return ((nullptr != p) and ...); },
-                       this->value_ptr_,
-                       this->value_deleter_,
-                       this->comparison_op_,
-                       this->clone_op_,
-                       this->value_type_info_);
+    return vtable_ != nullptr;
 }
 
-constexpr void
-atom::set_null_() {
-    this->value_ptr_       = nullptr;
-    this->value_deleter_   = nullptr;
-    this->comparison_op_   = nullptr;
-    this->clone_op_        = nullptr;
-    this->value_type_info_ = nullptr;
+constexpr auto
+atom::value_ptr_() const -> void const* {
+    if (vtable_->is_inline) { return storage_.buffer.data(); }
+    return storage_.heap_ptr;
 }
 
 constexpr atom::~atom() {
-    if (this->no_null_members_()) {
-        (*this->value_deleter_)(this->value_ptr_);
-        this->set_null_();
+    if (this->no_null_members_() and not vtable_->is_inline) {
+        (*vtable_->destroy)(storage_.heap_ptr);
     }
 }
 
-constexpr atom::atom(const atom& other)
-    : value_ptr_{ (*other.clone_op_)(other.value_ptr_) },
-      value_deleter_{ other.value_deleter_ },
-      comparison_op_{ other.comparison_op_ },
-      clone_op_{ other.clone_op_ },
-      value_type_info_{ other.value_type_info_ } {}
+constexpr atom::atom(const atom& other) : vtable_{ other.vtable_ } {
+    if (not this->no_null_members_()) { return; }
+
+    if (vtable_->is_inline) {
+        storage_ = other.storage_;
+    } else {
+        storage_.heap_ptr = (*vtable_->clone)(other.storage_.heap_ptr);
+    }
+}
 
 constexpr atom::atom(atom&& other) noexcept { swap(*this, other); }
 
@@ -199,20 +387,52 @@ atom::operator=(atom&& other) noexcept {
 
 template<typename T>
 constexpr auto
-atom_cast(const atom& x) -> std::optional<T> {
-    if (x.no_null_members_() and typeid(T) == *x.value_type_info_) {
-        return *static_cast<T*>(x.value_ptr_);
+atom_get_if(const atom& x) -> T const* {
+    if (x.no_null_members_() and typeid(T) == *x.vtable_->type_info) {
+        return static_cast<T const*>(x.value_ptr_());
     }
+    return nullptr;
+}
+
+/// Returns reference to the stored value.
+///
+/// Throws std::runtime_error if the atom does not hold value of type T.
+template<typename T>
+[[nodiscard]]
+constexpr auto
+atom_get(const atom& x) -> const T& {
+    if (const auto ptr = atom_get_if<T>(x)) { return *ptr; }
+    throw std::runtime_error{ "atom_get: atom does not hold value of requested type!" };
+}
+
+/// Returns copy of the stored value or std::nullopt if it is not of type T.
+template<typename T>
+[[nodiscard]]
+constexpr auto
+atom_cast(const atom& x) -> std::optional<T> {
+    if (const auto ptr = atom_get_if<T>(x)) { return *ptr; }
     return {};
 }
 
 constexpr void
 swap(atom& lhs, atom& rhs) noexcept {
-    std::swap(lhs.value_ptr_, rhs.value_ptr_);
-    std::swap(lhs.value_deleter_, rhs.value_deleter_);
-    std::swap(lhs.comparison_op_, rhs.comparison_op_);
-    std::swap(lhs.clone_op_, rhs.clone_op_);
-    std::swap(lhs.value_type_info_, rhs.value_type_info_);
+    std::swap(lhs.storage_, rhs.storage_);
+    std::swap(lhs.vtable_, rhs.vtable_);
+}
+
+[[nodiscard]]
+inline auto
+hash_value(const atom& x) -> std::size_t {
+    if (not x.no_null_members_()) { return 0uz; }
+    return sstd::hash_combine(x.vtable_->type_info->hash_code(),
+                              (*x.vtable_->hash)(x.value_ptr_()));
+}
+
+[[nodiscard]]
+inline auto
+atom_type(const atom& x) -> const std::type_info& {
+    if (not x.no_null_members_()) { return typeid(void); }
+    return *x.vtable_->type_info;
 }
 
 template<typename T, typename... U>
@@ -220,34 +440,75 @@ template<typename T, typename... U>
 constexpr auto
 atom_is_of_type(const atom& x) -> bool {
     if (x.no_null_members_()) {
-        return *x.value_type_info_ == typeid(T) or ((*x.value_type_info_ == typeid(U)) or ...);
+        const auto& info = *x.vtable_->type_info;
+        return info == typeid(T) or ((info == typeid(U)) or ...);
     }
     return false;
 }
 
 template<typename T, typename U>
 constexpr cons::cons(T&& car, U&& cdr)
-    : car_{ std::make_unique<sexpr>(std::forward<T>(car)) },
-      cdr_{ std::make_unique<sexpr>(std::forward<U>(cdr)) } {}
+    : node_{ detail::make_cons_node(sexpr(std::forward<T>(car)), sexpr(std::forward<U>(cdr))) } {}
+
+constexpr cons::cons() : node_{ detail::make_cons_node(null, null) } {}
+
+constexpr void
+cons::release_() noexcept {
+    // Returns true if the last reference was dropped.
+    const auto drop_ref = [](detail::cons_node* const node) {
+        if consteval {
+            return --node->refs == 0;
+        } else {
+            return std::atomic_ref{ node->refs }.fetch_sub(1, std::memory_order_acq_rel) == 1;
+        }
+    };
+
+    // Spine is released iteratively by detaching the cdr before destroying the cell,
+    // so destroying long lists does not recurse.
+    auto* node = std::exchange(node_, nullptr);
+    while (node != nullptr and drop_ref(node)) {
+        auto* next = static_cast<detail::cons_node*>(nullptr);
+        if (const auto tail = std::get_if<cons>(&node->cdr)) {
+            next = std::exchange(tail->node_, nullptr);
+        }
+        detail::destroy_cons_node(node);
+        node = next;
+    }
+}
+
+constexpr cons::~cons() { release_(); }
 
-constexpr cons::cons(const cons& other) {
-    this->car_ = std::make_unique<sexpr>(*other.car_);
-    this->cdr_ = std::make_unique<sexpr>(*other.cdr_);
+constexpr cons::cons(const cons& other) noexcept : node_{ other.node_ } {
+    if (node_ == nullptr) { return; }
+
+    if consteval {
+        ++node_->refs;
+    } else {
+        std::atomic_ref{ node_->refs }.fetch_add(1, std::memory_order_relaxed);
+    }
 }
 
+constexpr cons::cons(cons&& other) noexcept : node_{ std::exchange(other.node_, nullptr) } {}
+
 constexpr auto
-cons::operator=(const cons& other) -> cons& {
+cons::operator=(const cons& other) noexcept -> cons& {
     return *this = auto{ other }; // Makes sure self assignment is benign.
 }
 
+constexpr auto
+cons::operator=(cons&& other) noexcept -> cons& {
+    std::swap(node_, other.node_);
+    return *this;
+}
+
 constexpr auto
 cons::car() const -> const sexpr& {
-    return *this->car_;
+    return node_->car;
 }
 
 constexpr auto
 cons::cdr() const -> const sexpr& {
-    return *this->cdr_;
+    return node_->cdr;
 }
 
 constexpr auto
@@ -256,7 +517,82 @@ operator==(const cons& lhs, const cons& rhs) -> bool {
         tyvi::sstd::overloaded{ []<sexpr_like T>(const T& lhs, const T& rhs) { return lhs == rhs; },
                                 [](auto&&, auto&&) { return false; } };
 
-    return std::visit(op, lhs.car(), rhs.car()) and std::visit(op, lhs.cdr(), rhs.cdr());
+    // Spines are walked iteratively, so only nesting of lists recurses.
+    for (auto l = &lhs, r = &rhs;;) {
+        if (l->node_ == r->node_) { return true; }
+        if !consteval {
+            if (hash_value(*l) != hash_value(*r)) { return false; }
+        }
+        if (not std::visit(op, l->car(), r->car())) { return false; }
+
+        const auto l_next = std::get_if<cons>(&l->cdr());
+        const auto r_next = std::get_if<cons>(&r->cdr());
+        if (l_next == nullptr or r_next == nullptr) {
+            return std::visit(op, l->cdr(), r->cdr());
+        }
+        l = l_next;
+        r = r_next;
+    }
+}
+
+/// Structural hash consistent with operator==.
+[[nodiscard]]
+inline auto
+hash_value(const sexpr& x) -> std::size_t {
+    static constexpr auto null_hash = 0x6e756c6cuz;
+    return std::visit(sstd::overloaded{ [](null_type) { return null_hash; },
+                                        [](const auto& y) { return hash_value(y); } },
+                      x);
+}
+
+[[nodiscard]]
+inline auto
+hash_value(const cons& c) -> std::size_t {
+    const auto cached = [](const cons& x) { return std::atomic_ref{ x.node_->hash }; };
+    if (const auto h = cached(c).load(std::memory_order_relaxed); h != 0) { return h; }
+
+    // Spine is walked iteratively up to the first cell with cached hash or the tail,
+    // and the hashes are computed back to front, so only nesting of lists recurses.
+    auto spine = std::vector<cons const*>{};
+    auto h     = 0uz;
+    for (auto x = &c;;) {
+        if (const auto xh = cached(*x).load(std::memory_order_relaxed); xh != 0) {
+            h = xh;
+            break;
+        }
+        spine.push_back(x);
+
+        const auto next = std::get_if<cons>(&x->cdr());
+        if (next == nullptr) {
+            h = hash_value(x->cdr());
+            break;
+        }
+        x = next;
+    }
+
+    // Cells are immutable, so racing threads compute the same value.
+    for (const auto* const x : spine | std::views::reverse) {
+        h = sstd::hash_combine(hash_value(x->car()), h);
+        h = h == 0 ? 1uz : h;
+        cached(*x).store(h, std::memory_order_relaxed);
+    }
+    return h;
 }
 
 } // namespace tyvi::actions
+
+template<>
+struct std::hash<tyvi::actions::atom> {
+    [[nodiscard]]
+    static auto operator()(const tyvi::actions::atom& x) -> std::size_t {
+        return hash_value(x);
+    }
+};
+
+template<>
+struct std::hash<tyvi::actions::cons> {
+    [[nodiscard]]
+    static auto operator()(const tyvi::actions::cons& x) -> std::size_t {
+        return hash_value(x);
+    }
+};
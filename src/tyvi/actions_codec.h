@@ -0,0 +1,327 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <memory_resource>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "tyvi/actions_ast.h"
+#include "tyvi/actions_list.h"
+
+namespace tyvi::actions {
+
+/// Encoders and decoders of atom payload types, identified by stable tags.
+///
+/// Tags are part of the encoding, so the same type has to be registered
+/// with the same tag on every rank and in every program reading cached encodings.
+/// Tags below first_user_tag are reserved for the builtin types registered by the constructor.
+class [[nodiscard]] codec_registry {
+  public:
+    using tag_type = std::uint32_t;
+    /// Appends encoded value of the atom.
+    using encoder = std::function<void(const atom&, std::vector<std::byte>&)>;
+    /// Decodes atom from the whole given payload.
+    using decoder = std::function<atom(std::span<const std::byte>)>;
+
+    static constexpr tag_type first_user_tag = 64;
+
+  private:
+    struct codec {
+        tag_type tag;
+        encoder encode;
+        decoder decode;
+    };
+
+    std::unordered_map<std::type_index, codec> by_type_;
+    std::unordered_map<tag_type, codec> by_tag_;
+
+    void add_codec_(const std::type_info& type, codec c) {
+        if (by_type_.contains(type)) {
+            throw std::runtime_error{ "Atom type is already registered to codec registry!" };
+        }
+        if (by_tag_.contains(c.tag)) {
+            throw std::runtime_error{ "Atom tag is already registered to codec registry!" };
+        }
+        by_tag_.emplace(c.tag, c);
+        by_type_.emplace(type, std::move(c));
+    }
+
+  public:
+    /// Registry with builtin types: intrinsic, bool, int, std::int64_t, std::uint64_t,
+    /// float, double and std::string.
+    codec_registry();
+
+    /// Registers trivially copyable T, which is encoded as its object representation.
+    template<typename T>
+        requires std::is_trivially_copyable_v<T>
+    void add(const tag_type tag) {
+        add<T>(
+            tag,
+            [](const T& x, std::vector<std::byte>& out) {
+                const auto bytes = std::as_bytes(std::span{ &x, 1uz });
+                out.insert(out.end(), bytes.begin(), bytes.end());
+            },
+            [](const std::span<const std::byte> payload) -> T {
+                if (payload.size() != sizeof(T)) {
+                    throw std::runtime_error{ "Atom payload has wrong size!" };
+                }
+                auto x = T{};
+                std::memcpy(&x, payload.data(), sizeof(T));
+                return x;
+            });
+    }
+
+    /// Registers T with given encoder and decoder.
+    template<typename T, typename Encode, typename Decode>
+        requires std::invocable<const Encode&, const T&, std::vector<std::byte>&>
+                 and std::same_as<std::invoke_result_t<const Decode&, std::span<const std::byte>>,
+                                  T>
+    void add(const tag_type tag, Encode encode, Decode decode) {
+        add_codec_(typeid(T),
+                   codec{ .tag    = tag,
+                          .encode = [encode = std::move(encode)](const atom& a,
+                                                                 std::vector<std::byte>& out) {
+                              std::invoke(encode, atom_get<T>(a), out);
+                          },
+                          .decode = [decode = std::move(decode)](
+                                        const std::span<const std::byte> payload) -> atom {
+                              return std::invoke(decode, payload);
+                          } });
+    }
+
+    /// Tag and encoder of the type of a, throws if it is not registered.
+    [[nodiscard]]
+    auto encoder_of(const atom& a) const -> std::pair<tag_type, const encoder&> {
+        const auto it = by_type_.find(atom_type(a));
+        if (it == by_type_.end()) {
+            throw std::runtime_error{ "Trying to encode atom of unregistered type!" };
+        }
+        return { it->second.tag, it->second.encode };
+    }
+
+    /// Decoder of tag, throws if it is not registered.
+    [[nodiscard]]
+    auto decoder_of(const tag_type tag) const -> const decoder& {
+        const auto it = by_tag_.find(tag);
+        if (it == by_tag_.end()) {
+            throw std::runtime_error{ "Trying to decode atom of unregistered tag!" };
+        }
+        return it->second.decode;
+    }
+};
+
+inline codec_registry::codec_registry() {
+    add<intrinsic>(0);
+    // Object representation of bool other than 0 or 1 is undefined behaviour,
+    // so it is not decoded with memcpy.
+    add<bool>(
+        1,
+        [](const bool x, std::vector<std::byte>& out) {
+            out.push_back(x ? std::byte{ 1 } : std::byte{ 0 });
+        },
+        [](const std::span<const std::byte> payload) {
+            if (payload.size() != 1uz or payload.front() > std::byte{ 1 }) {
+                throw std::runtime_error{ "Malformed bool in sexpr encoding!" };
+            }
+            return payload.front() == std::byte{ 1 };
+        });
+    add<int>(2);
+    add<std::int64_t>(3);
+    add<std::uint64_t>(4);
+    add<float>(5);
+    add<double>(6);
+    add<std::string>(
+        7,
+        [](const std::string& x, std::vector<std::byte>& out) {
+            const auto bytes = std::as_bytes(std::span{ x });
+            out.insert(out.end(), bytes.begin(), bytes.end());
+        },
+        [](const std::span<const std::byte> payload) {
+            return std::string(reinterpret_cast<const char*>(payload.data()), payload.size());
+        });
+}
+
+namespace detail {
+
+/// Kind of encoded node.
+///
+/// Spine of a list is encoded as its length, elements and the tail,
+/// so only nesting of lists is recursive.
+enum class codec_node : std::uint8_t { null, atom, list };
+
+inline constexpr auto codec_version = std::byte{ 1 };
+
+/// Maximum nesting of lists accepted by decode, which bounds its recursion.
+inline constexpr auto codec_max_depth = 1024uz;
+
+inline void
+write_varint(std::uint64_t x, std::vector<std::byte>& out) {
+    while (x >= 0x80u) {
+        out.push_back(static_cast<std::byte>((x & 0x7fu) | 0x80u));
+        x >>= 7u;
+    }
+    out.push_back(static_cast<std::byte>(x));
+}
+
+/// Payload is encoded into scratch first, since its length precedes it.
+/// Scratch is shared by all atoms, so its allocation is reused.
+inline void
+encode_node(const sexpr& s,
+            const codec_registry& reg,
+            std::vector<std::byte>& out,
+            std::vector<std::byte>& scratch) {
+    auto op = sstd::overloaded{
+        [&](null_type) { out.push_back(static_cast<std::byte>(codec_node::null)); },
+        [&](const atom& a) {
+            const auto [tag, encode] = reg.encoder_of(a);
+
+            auto& payload = scratch;
+            payload.clear();
+            std::invoke(encode, a, payload);
+
+            out.push_back(static_cast<std::byte>(codec_node::atom));
+            write_varint(tag, out);
+            write_varint(payload.size(), out);
+            out.insert(out.end(), payload.begin(), payload.end());
+        },
+        [&](const cons& c) {
+            auto n    = 0uz;
+            auto tail = sexpr{ c };
+            while (const auto next = std::get_if<cons>(&tail)) {
+                ++n;
+                tail = sexpr{ next->cdr() }; // Copy before next is released.
+            }
+
+            out.push_back(static_cast<std::byte>(codec_node::list));
+            write_varint(n, out);
+
+            auto x = sexpr{ c };
+            while (const auto next = std::get_if<cons>(&x)) {
+                encode_node(next->car(), reg, out, scratch);
+                x = sexpr{ next->cdr() };
+            }
+            encode_node(tail, reg, out, scratch);
+        }
+    };
+    std::visit(op, s);
+}
+
+/// Bounds checked cursor over encoded bytes.
+class codec_reader {
+    std::span<const std::byte> bytes_;
+
+  public:
+    explicit codec_reader(const std::span<const std::byte> bytes) : bytes_{ bytes } {}
+
+    [[nodiscard]]
+    auto empty() const -> bool {
+        return bytes_.empty();
+    }
+
+    [[nodiscard]]
+    auto take(const std::size_t n) -> std::span<const std::byte> {
+        if (n > bytes_.size()) { throw std::runtime_error{ "Truncated sexpr encoding!" }; }
+        const auto x = bytes_.first(n);
+        bytes_       = bytes_.subspan(n);
+        return x;
+    }
+
+    [[nodiscard]]
+    auto byte() -> std::byte {
+        return take(1uz).front();
+    }
+
+    [[nodiscard]]
+    auto varint() -> std::uint64_t {
+        auto x = std::uint64_t{ 0 };
+        for (auto shift = 0u; shift < 64u; shift += 7u) {
+            const auto b = std::to_integer<std::uint64_t>(byte());
+            x |= (b & 0x7fu) << shift;
+            if ((b & 0x80u) == 0u) { return x; }
+        }
+        throw std::runtime_error{ "Malformed varint in sexpr encoding!" };
+    }
+};
+
+inline auto
+decode_node(codec_reader& in, const codec_registry& reg, const std::size_t depth = 0) -> sexpr {
+    switch (static_cast<codec_node>(in.byte())) {
+        case codec_node::null: return null;
+        case codec_node::atom: {
+            const auto tag  = in.varint();
+            const auto size = in.varint();
+            if (tag > std::numeric_limits<codec_registry::tag_type>::max()) {
+                throw std::runtime_error{ "Trying to decode atom of unregistered tag!" };
+            }
+            const auto& decode = reg.decoder_of(static_cast<codec_registry::tag_type>(tag));
+            return std::invoke(decode, in.take(size));
+        }
+        case codec_node::list: {
+            if (depth >= codec_max_depth) {
+                throw std::runtime_error{ "Too deeply nested lists in sexpr encoding!" };
+            }
+            const auto n = in.varint();
+
+            auto elems = std::vector<sexpr>{};
+            for (auto i = 0uz; i < n; ++i) { elems.push_back(decode_node(in, reg, depth + 1uz)); }
+
+            auto s = decode_node(in, reg, depth + 1uz);
+            for (auto& x : elems | std::views::reverse) { s = cons(std::move(x), std::move(s)); }
+            return s;
+        }
+    }
+    throw std::runtime_error{ "Unknown node kind in sexpr encoding!" };
+}
+
+} // namespace detail
+
+/// Compact binary encoding of s.
+///
+/// Atoms are encoded with the codecs of reg, so all their types have to be registered.
+/// Shared subtrees are encoded separately for each occurrence.
+[[nodiscard]]
+inline auto
+encode(const sexpr& s, const codec_registry& reg) -> std::vector<std::byte> {
+    auto out     = std::vector<std::byte>{ detail::codec_version };
+    auto scratch = std::vector<std::byte>{};
+    detail::encode_node(s, reg, out, scratch);
+    return out;
+}
+
+/// Decodes sexpr from bytes given by encode.
+///
+/// Decoders are given views of the payloads in bytes, so only values that own memory,
+/// e.g. std::string, copy their payload. Cells are allocated from the given resource,
+/// e.g. a node_arena. Throws if lists are nested deeper than detail::codec_max_depth.
+[[nodiscard]]
+inline auto
+decode(const std::span<const std::byte> bytes,
+       const codec_registry& reg,
+       std::pmr::memory_resource* const resource = node_resource()) -> sexpr {
+    const auto _ = node_resource_scope(resource);
+
+    auto in = detail::codec_reader(bytes);
+    if (in.byte() != detail::codec_version) {
+        throw std::runtime_error{ "Unsupported sexpr encoding version!" };
+    }
+
+    auto s = detail::decode_node(in, reg);
+    if (not in.empty()) { throw std::runtime_error{ "Trailing bytes in sexpr encoding!" }; }
+    return s;
+}
+
+} // namespace tyvi::actions
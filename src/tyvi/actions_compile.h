@@ -0,0 +1,244 @@
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "tyvi/actions_ast.h"
+#include "tyvi/actions_environment.h"
+#include "tyvi/actions_eval.h"
+#include "tyvi/actions_list.h"
+#include "tyvi/execution.h"
+
+namespace tyvi::actions {
+
+namespace detail {
+
+struct plan_node;
+
+struct plan_call {
+    /// Resolved procedure or expression which evaluates to one.
+    std::variant<procedure, sync_procedure, std::unique_ptr<const plan_node>> callee;
+    std::vector<plan_node> args;
+    /// Argument list built at compile time, if all arguments are constants.
+    std::optional<sexpr> constant_args;
+    /// Callee and all calls in arguments are sync_procedures.
+    bool synchronous{ false };
+};
+
+struct plan_node {
+    /// Constant value or procedure call.
+    std::variant<sexpr, plan_call> op;
+};
+
+template<typename... Symbols>
+[[nodiscard]]
+auto
+compile_node(const sexpr& body, const environment& env) -> plan_node {
+    auto op = tyvi::sstd::overloaded{
+        [&](const atom& x) -> plan_node {
+            if (atom_is_of_type<intrinsic, Symbols...>(x)) {
+                if (const auto v = lookup_symbol(x, env)) { return { *v }; }
+                throw std::runtime_error{ "Trying to compile unbound symbol!" };
+            }
+            return { sexpr{ x } };
+        },
+        [&](const cons& c) -> plan_node {
+            if (const auto q = quoted(c)) { return { *q }; }
+
+            if (not std::visit(is_list, c.cdr())) {
+                throw std::runtime_error{ "Arguments of procedure call are not a proper list!" };
+            }
+
+            auto call = plan_call{};
+
+            auto callee = compile_node<Symbols...>(c.car(), env);
+            if (const auto p = std::get_if<sexpr>(&callee.op)) {
+                if (not std::holds_alternative<atom>(*p)
+                    or not atom_is_of_type<procedure, sync_procedure>(std::get<atom>(*p))) {
+                    throw std::runtime_error{ "Trying to invoke non-procedure!" };
+                }
+
+                const auto& a = std::get<atom>(*p);
+                if (const auto f = atom_get_if<procedure>(a)) {
+                    call.callee = *f;
+                } else {
+                    call.callee = atom_get<sync_procedure>(a);
+                }
+            } else {
+                call.callee = std::make_unique<const plan_node>(std::move(callee));
+            }
+
+            for (const auto& x : list_view(c.cdr())) {
+                call.args.push_back(compile_node<Symbols...>(x, env));
+            }
+
+            const auto is_constant = [](const plan_node& n) {
+                return std::holds_alternative<sexpr>(n.op);
+            };
+
+            if (std::ranges::all_of(call.args, is_constant)) {
+                auto values = std::vector<sexpr>{};
+                for (const auto& n : call.args) { values.push_back(std::get<sexpr>(n.op)); }
+                call.constant_args = list(std::from_range, values);
+            }
+
+            const auto is_synchronous = [](const plan_node& n) {
+                const auto arg_call = std::get_if<plan_call>(&n.op);
+                return arg_call == nullptr or arg_call->synchronous;
+            };
+
+            call.synchronous = std::holds_alternative<sync_procedure>(call.callee)
+                               and std::ranges::all_of(call.args, is_synchronous);
+
+            return { std::move(call) };
+        },
+        [](null_type) -> plan_node { throw std::runtime_error{ "Trying to compile null!" }; }
+    };
+
+    return std::visit(op, body);
+}
+
+/// Runs synchronous call inline.
+[[nodiscard]]
+inline auto
+execute_synchronous(const plan_call& call) -> sexpr {
+    const auto& f = std::get<sync_procedure>(call.callee);
+    if (call.constant_args) { return std::invoke(f, *call.constant_args); }
+
+    auto args = std::vector<sexpr>{};
+    args.reserve(call.args.size());
+    for (const auto& arg : call.args) {
+        if (const auto c = std::get_if<sexpr>(&arg.op)) {
+            args.push_back(*c);
+        } else {
+            args.push_back(execute_synchronous(std::get<plan_call>(arg.op)));
+        }
+    }
+    return std::invoke(f, list(std::from_range, args));
+}
+
+[[nodiscard]]
+inline auto execute(const plan_node& node) -> sexpr_sender;
+
+[[nodiscard]]
+inline auto
+execute_args(const plan_call& call) -> sexpr_sender {
+    if (call.constant_args) { return exec::just(*call.constant_args); }
+
+    auto senders = std::vector<sexpr_sender>{};
+    senders.reserve(call.args.size());
+    for (const auto& arg : call.args) { senders.push_back(execute(arg)); }
+
+    return exec::when_all_vector(std::move(senders))
+           | exec::then([r = node_resource()](const std::vector<sexpr>& args) -> sexpr {
+                 const auto _ = node_resource_scope(r);
+                 return list(std::from_range, args);
+             });
+}
+
+inline auto
+execute(const plan_node& node) -> sexpr_sender {
+    auto op = tyvi::sstd::overloaded{
+        [](const sexpr& constant) -> sexpr_sender { return exec::just(constant); },
+        [](const plan_call& call) -> sexpr_sender {
+            // Whole synchronous subtree is run inline in one sender.
+            if (call.synchronous) {
+                return exec::just(&call)
+                       | exec::then([r = node_resource()](const plan_call* c) -> sexpr {
+                             const auto _ = node_resource_scope(r);
+                             return execute_synchronous(*c);
+                         });
+            }
+
+            auto callee_op = tyvi::sstd::overloaded{
+                [&](const procedure& f) -> sexpr_sender {
+                    if (call.constant_args) { return std::invoke(f, *call.constant_args); }
+                    return execute_args(call)
+                           | exec::let_value([&f, r = node_resource()](sexpr& args) {
+                                 const auto _ = node_resource_scope(r);
+                                 return std::invoke(f, std::move(args));
+                             });
+                },
+                [&](const sync_procedure& f) -> sexpr_sender {
+                    return execute_args(call)
+                           | exec::then([&f, r = node_resource()](sexpr args) -> sexpr {
+                                 const auto _ = node_resource_scope(r);
+                                 return std::invoke(f, std::move(args));
+                             });
+                },
+                [&](const std::unique_ptr<const plan_node>& callee) -> sexpr_sender {
+                    return exec::when_all(execute(*callee), execute_args(call))
+                           | exec::let_value([r = node_resource()](const sexpr& p, sexpr& args) {
+                                 const auto _ = node_resource_scope(r);
+                                 return invoke_procedure(p, std::move(args));
+                             });
+                }
+            };
+            return std::visit(callee_op, call.callee);
+        }
+    };
+
+    return std::visit(op, node.op);
+}
+
+} // namespace detail
+
+/// Executable form of an s-expression.
+///
+/// Symbols are resolved, quotes are validated and subexpressions
+/// without procedure calls are folded into constants once at compile time.
+/// Running a plan only invokes the procedures.
+/// Subtrees which only call sync_procedures are run inline without intermediate senders.
+/// Copies of a plan share the compiled program.
+class [[nodiscard]] plan {
+    std::shared_ptr<const detail::plan_node> root_;
+
+  public:
+    explicit plan(detail::plan_node root)
+        : root_{ std::make_shared<const detail::plan_node>(std::move(root)) } {}
+
+    /// Sender of the value of the program, same as eval would give.
+    ///
+    /// Plan does not have to outlive the returned sender.
+    [[nodiscard]]
+    auto run() const -> sexpr_sender {
+        return exec::just(root_)
+               | exec::let_value([r = node_resource()](
+                                     const std::shared_ptr<const detail::plan_node>& root) {
+                     const auto _ = node_resource_scope(r);
+                     return detail::execute(*root);
+                 });
+    }
+
+    /// Value of the program if it was folded into a constant, otherwise nullptr.
+    [[nodiscard]]
+    auto constant() const -> sexpr const* {
+        return std::get_if<sexpr>(&root_->op);
+    }
+};
+
+/// Compiles body in given environment.
+///
+/// Unbound symbols and malformed forms are reported here, instead of when plan is run.
+template<typename... Symbols>
+[[nodiscard]]
+auto
+compile(const sexpr& body, const environment& env) -> plan {
+    return plan(detail::compile_node<Symbols...>(body, env));
+}
+
+/// Compiles body in environment given as association list.
+template<typename... Symbols>
+[[nodiscard]]
+auto
+compile(const sexpr& body, const sexpr& env) -> plan {
+    return compile<Symbols...>(body, environment(env));
+}
+
+} // namespace tyvi::actions
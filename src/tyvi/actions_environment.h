@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+
+#include "tyvi/actions_ast.h"
+#include "tyvi/actions_list.h"
+
+namespace tyvi::actions {
+
+/// Symbol table used by eval.
+///
+/// Symbols are hashed atoms, so lookup is O(1) and does not allocate.
+/// Frames are immutable and shared between copies, so copying is O(1).
+/// Lookup falls back to parent frames if symbol is not bound in this frame.
+class [[nodiscard]] environment {
+    struct frame {
+        std::unordered_map<atom, sexpr> table;
+        std::shared_ptr<const frame> parent;
+    };
+
+    std::shared_ptr<const frame> frame_{};
+
+  public:
+    /// Empty environment.
+    environment() = default;
+
+    /// Binds symbols of association list, i.e. list of (symbol . value) pairs.
+    ///
+    /// Same as assoc, earlier pairs shadow later ones
+    /// and elements which are not pairs with atom car are ignored.
+    explicit environment(const sexpr& alist, environment parent = {});
+
+    /// Returns pointer to bound value or nullptr if symbol is not bound.
+    [[nodiscard]]
+    auto lookup(const atom& symbol) const -> sexpr const*;
+
+    /// New environment with bindings of alist shadowing the ones in this.
+    [[nodiscard]]
+    auto extend(const sexpr& alist) const -> environment;
+
+    /// Number of symbols bound in this frame and its parents, including shadowed ones.
+    [[nodiscard]]
+    auto size() const -> std::size_t;
+
+    /// Copies of an environment have the same identity.
+    [[nodiscard]]
+    auto identity() const noexcept -> void const* {
+        return frame_.get();
+    }
+};
+
+inline environment::environment(const sexpr& alist, environment parent) {
+    if (not std::visit(is_list, alist)) {
+        throw std::runtime_error{ "Environment has to be constructed from a list!" };
+    }
+
+    auto f    = std::make_shared<frame>();
+    f->parent = std::move(parent.frame_);
+
+    for (const auto& x : list_view(alist)) {
+        if (not std::holds_alternative<cons>(x)) { continue; }
+        const auto& pair = std::get<cons>(x);
+        if (not std::holds_alternative<atom>(pair.car())) { continue; }
+
+        f->table.try_emplace(std::get<atom>(pair.car()), pair.cdr());
+    }
+
+    frame_ = std::move(f);
+}
+
+inline auto
+environment::lookup(const atom& symbol) const -> sexpr const* {
+    for (auto* f = frame_.get(); f != nullptr; f = f->parent.get()) {
+        if (const auto it = f->table.find(symbol); it != f->table.end()) { return &it->second; }
+    }
+    return nullptr;
+}
+
+inline auto
+environment::extend(const sexpr& alist) const -> environment {
+    return environment(alist, *this);
+}
+
+inline auto
+environment::size() const -> std::size_t {
+    auto n = 0uz;
+    for (auto* f = frame_.get(); f != nullptr; f = f->parent.get()) { n += f->table.size(); }
+    return n;
+}
+
+} // namespace tyvi::actions
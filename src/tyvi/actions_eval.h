@@ -1,113 +1,510 @@
 #pragma once
 
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <ranges>
 #include <stdexcept>
+#include <tuple>
+#include <unordered_map>
 #include <utility>
 #include <variant>
+#include <vector>
 
 #include "tyvi/actions_ast.h"
+#include "tyvi/actions_environment.h"
 #include "tyvi/actions_list.h"
+#include "tyvi/actions_memo.h"
+#include "tyvi/actions_schedule.h"
+#include "tyvi/actions_trace.h"
 #include "tyvi/execution.h"
+#include "tyvi/instrumentation.h"
 
 namespace tyvi::actions {
 
 static const auto intrinsic_env =
-    list(cons(intrinsic::car, procedure([](sexpr s) -> sexpr_sender {
-                  return exec::just(std::move(s)) | exec::then([](const sexpr& s) -> sexpr {
-                             if (not std::holds_alternative<cons>(s)) {
-                                 throw std::runtime_error{ "Car argument is not (one long) list!" };
-                             }
-
-                             const auto arg = std::get<cons>(s).car();
-
-                             if (not std::holds_alternative<cons>(arg)) {
-                                 throw std::runtime_error{
-                                     "Car argument is not of form: ((a, b), null)"
-                                 };
-                             }
-                             return std::get<cons>(arg).car();
-                         });
+    list(cons(intrinsic::car, sync_procedure([](const sexpr& s) -> sexpr {
+                  if (not std::holds_alternative<cons>(s)) {
+                      throw std::runtime_error{ "Car argument is not (one long) list!" };
+                  }
+
+                  const auto& arg = std::get<cons>(s).car();
+
+                  if (not std::holds_alternative<cons>(arg)) {
+                      throw std::runtime_error{ "Car argument is not of form: ((a, b), null)" };
+                  }
+                  return std::get<cons>(arg).car();
               })),
-         cons(intrinsic::cdr, procedure([](sexpr s) -> sexpr_sender {
-                  return exec::just(std::move(s)) | exec::then([](const sexpr& s) -> sexpr {
-                             if (not std::holds_alternative<cons>(s)) {
-                                 throw std::runtime_error{ "Cdr argument is not (one long) list!" };
-                             }
-
-                             const auto arg = std::get<cons>(s).car();
-
-                             if (not std::holds_alternative<cons>(arg)) {
-                                 throw std::runtime_error{
-                                     "Cdr argument is not of form: ((a, b), null)"
-                                 };
-                             }
-                             return std::get<cons>(arg).cdr();
-                         });
+         cons(intrinsic::cdr, sync_procedure([](const sexpr& s) -> sexpr {
+                  if (not std::holds_alternative<cons>(s)) {
+                      throw std::runtime_error{ "Cdr argument is not (one long) list!" };
+                  }
+
+                  const auto& arg = std::get<cons>(s).car();
+
+                  if (not std::holds_alternative<cons>(arg)) {
+                      throw std::runtime_error{ "Cdr argument is not of form: ((a, b), null)" };
+                  }
+                  return std::get<cons>(arg).cdr();
               })));
 
+/// Intrinsics are looked up before the user environment, so they can not be shadowed.
+[[nodiscard]]
+inline auto
+intrinsic_environment() -> const environment& {
+    static const auto env = environment(intrinsic_env);
+    return env;
+}
+
+/// Optional features of eval.
+struct eval_options {
+    /// Shares senders of identical subexpressions, see memo_table for requirements.
+    std::optional<memo_table> memo{};
+    /// Starts arguments ordered by their critical path, see critical_path_scheduler.
+    ///
+    /// Purely synchronous subtrees are still evaluated inline and they are not recorded.
+    /// Critical paths use the costs measured before the eval, not the ones measured during it.
+    std::optional<critical_path_scheduler> scheduler{};
+    /// Records procedure calls, see eval_tracer.
+    ///
+    /// Ignored at zero cost, unless tyvi is build with tyvi_ENABLE_INSTRUMENTATION.
+    std::optional<eval_tracer> tracer{};
+    /// Grain size and scheduler used to map the arguments of each call, see map_options.
+    ///
+    /// Ignored when scheduler is given, as it orders the arguments itself.
+    map_options args{};
+};
+
+namespace detail {
+
+/// Value of symbol or nullptr if it is unbound.
+[[nodiscard]]
+inline auto
+lookup_symbol(const atom& x, const environment& env) -> sexpr const* {
+    if (const auto v = intrinsic_environment().lookup(x)) { return v; }
+    return env.lookup(x);
+}
+
+/// Argument of well formed quote form or nullptr if c is not one.
+[[nodiscard]]
+inline auto
+quoted(const cons& c) -> sexpr const* {
+    if (not std::holds_alternative<atom>(c.car())
+        or atom_cast<intrinsic>(std::get<atom>(c.car())) != intrinsic::quote) {
+        return nullptr;
+    }
+
+    if (not std::holds_alternative<cons>(c.cdr())) {
+        throw std::runtime_error{ "Quote argument is not (one long) list!" };
+    }
+
+    const auto& arg = std::get<cons>(c.cdr());
+
+    if (not std::holds_alternative<null_type>(arg.cdr())) {
+        throw std::runtime_error{ "Quote argument is not of form: (x, null)" };
+    }
+
+    return &arg.car();
+}
+
+/// Procedure in p, which is either procedure or sync_procedure.
+[[nodiscard]]
+inline auto
+invoke_procedure(const sexpr& p, sexpr args) -> sexpr_sender {
+    if (std::holds_alternative<atom>(p)) {
+        const auto& a = std::get<atom>(p);
+        if (const auto f = atom_get_if<procedure>(a)) { return std::invoke(*f, std::move(args)); }
+        if (const auto f = atom_get_if<sync_procedure>(a)) {
+            return exec::just(std::invoke(*f, std::move(args)));
+        }
+    }
+    throw std::runtime_error{ "Trying to invoke non-procedure!" };
+}
+
+/// Callee of procedure call, if it is a symbol or a literal bound to sync_procedure.
 template<typename... Symbols>
+[[nodiscard]]
 auto
-eval(const sexpr& body, const sexpr& env) -> sexpr_sender {
+sync_callee(const sexpr& car, const environment& env) -> sync_procedure const* {
+    if (not std::holds_alternative<atom>(car)) { return nullptr; }
+
+    const auto& x = std::get<atom>(car);
+    if (not atom_is_of_type<intrinsic, Symbols...>(x)) { return atom_get_if<sync_procedure>(x); }
+
+    const auto v = lookup_symbol(x, env);
+    if (v == nullptr or not std::holds_alternative<atom>(*v)) { return nullptr; }
+    return atom_get_if<sync_procedure>(std::get<atom>(*v));
+}
+
+/// Can body be evaluated inline, i.e. it only calls sync_procedures.
+///
+/// Malformed expressions and unbound symbols are not synchronous,
+/// so that they are reported by eval in the usual way.
+template<typename... Symbols>
+[[nodiscard]]
+auto
+is_synchronous(const sexpr& body, const environment& env) -> bool {
+    auto op = tyvi::sstd::overloaded{
+        [&](const atom& x) {
+            return not atom_is_of_type<intrinsic, Symbols...>(x)
+                   or lookup_symbol(x, env) != nullptr;
+        },
+        [&](const cons& c) {
+            if (std::holds_alternative<atom>(c.car())
+                and atom_cast<intrinsic>(std::get<atom>(c.car())) == intrinsic::quote) {
+                return std::holds_alternative<cons>(c.cdr())
+                       and std::holds_alternative<null_type>(std::get<cons>(c.cdr()).cdr());
+            }
+
+            if (sync_callee<Symbols...>(c.car(), env) == nullptr) { return false; }
+            if (not std::visit(is_list, c.cdr())) { return false; }
+
+            return std::ranges::all_of(list_view(c.cdr()), [&](const sexpr& x) {
+                return is_synchronous<Symbols...>(x, env);
+            });
+        },
+        [](null_type) { return false; }
+    };
+
+    return std::visit(op, body);
+}
+
+/// Facts about the calls of an expression, computed in one bottom-up pass per eval
+/// instead of again at every level of the recursion.
+///
+/// Calls are keyed by their cells, which stay alive as long as root does.
+/// Costs of critical paths are the ones of the cost model when eval was started.
+struct eval_analysis {
+    struct call {
+        /// See is_synchronous.
+        bool synchronous;
+        /// See critical_path, zero if eval has no scheduler.
+        double critical_path;
+    };
+
+    sexpr root;
+    std::unordered_map<void const*, call> calls{};
+
+    /// Call c or nullptr if it is not part of root.
+    [[nodiscard]]
+    auto find(const cons& c) const -> call const* {
+        const auto it = calls.find(&c.car());
+        return it == calls.end() ? nullptr : &it->second;
+    }
+};
+
+using eval_analysis_ptr = std::shared_ptr<const eval_analysis>;
+
+/// Analyzes call c and all calls in it that eval might visit, each shared cell once.
+/// Costs are taken from costs, or they are zero if it is nullptr.
+template<typename... Symbols>
+auto
+analyze_call(const cons& c,
+             const environment& env,
+             cost_model const* const costs,
+             eval_analysis& a) -> eval_analysis::call {
+    if (const auto it = a.calls.find(&c.car()); it != a.calls.end()) { return it->second; }
+
+    auto result = eval_analysis::call{ .synchronous = false, .critical_path = 0.0 };
+    if (std::holds_alternative<atom>(c.car())
+        and atom_cast<intrinsic>(std::get<atom>(c.car())) == intrinsic::quote) {
+        result.synchronous = is_synchronous<Symbols...>(c, env);
+    } else {
+        auto callee_path = 0.0;
+        if (const auto x = std::get_if<atom>(&c.car()); x and costs) {
+            callee_path = costs->cost(*x);
+        } else if (const auto callee = std::get_if<cons>(&c.car())) {
+            callee_path = analyze_call<Symbols...>(*callee, env, costs, a).critical_path;
+        }
+
+        auto args_synchronous = std::visit(is_list, c.cdr());
+        auto longest_arg      = 0.0;
+        if (args_synchronous) {
+            // Every argument is analyzed, since eval visits them even if one is asynchronous.
+            for (const auto& x : list_view(c.cdr())) {
+                if (const auto call = std::get_if<cons>(&x)) {
+                    const auto info  = analyze_call<Symbols...>(*call, env, costs, a);
+                    args_synchronous = args_synchronous and info.synchronous;
+                    longest_arg      = std::max(longest_arg, info.critical_path);
+                } else {
+                    args_synchronous = args_synchronous and is_synchronous<Symbols...>(x, env);
+                }
+            }
+        }
+        result.synchronous =
+            args_synchronous and sync_callee<Symbols...>(c.car(), env) != nullptr;
+        result.critical_path = callee_path + longest_arg;
+    }
+
+    a.calls.emplace(&c.car(), result);
+    return result;
+}
+
+template<typename... Symbols>
+[[nodiscard]]
+auto
+analyze(const sexpr& body, const environment& env, const eval_options& opts)
+    -> eval_analysis_ptr {
+    const auto* const costs = opts.scheduler ? &opts.scheduler->costs() : nullptr;
+
+    auto a = std::make_shared<eval_analysis>(eval_analysis{ .root = body });
+    if (const auto c = std::get_if<cons>(&a->root)) {
+        std::ignore = analyze_call<Symbols...>(*c, env, costs, *a);
+    }
+    return a;
+}
+
+/// Critical path of body, see eval_analysis.
+[[nodiscard]]
+inline auto
+analyzed_critical_path(const sexpr& body, const cost_model& costs, const eval_analysis& info)
+    -> double {
+    const auto* const c = std::get_if<cons>(&body);
+    if (c == nullptr) { return 0.0; }
+    if (const auto call = info.find(*c)) { return call->critical_path; }
+    return critical_path(body, costs);
+}
+
+/// Evaluates body inline. Assumes that is_synchronous(body, env).
+template<typename... Symbols>
+[[nodiscard]]
+auto
+eval_synchronous(const sexpr& body, const environment& env) -> sexpr {
+    auto op = tyvi::sstd::overloaded{
+        [&](const atom& x) -> sexpr {
+            if (atom_is_of_type<intrinsic, Symbols...>(x)) { return *lookup_symbol(x, env); }
+            return x;
+        },
+        [&](const cons& c) -> sexpr {
+            if (const auto q = quoted(c)) { return *q; }
+
+            auto args = std::vector<sexpr>{};
+            for (const auto& x : list_view(c.cdr())) {
+                args.push_back(eval_synchronous<Symbols...>(x, env));
+            }
+
+            return std::invoke(*sync_callee<Symbols...>(c.car(), env),
+                               list(std::from_range, args));
+        },
+        [](null_type) -> sexpr { throw std::runtime_error{ "Trying to eval null!" }; }
+    };
+
+    return std::visit(op, body);
+}
+
+template<typename... Symbols>
+[[nodiscard]]
+auto eval_impl(const sexpr& body,
+               const environment& env,
+               const eval_options& opts,
+               const eval_analysis_ptr& info) -> sexpr_sender;
+
+/// Evaluates arguments concurrently and joins them into a list.
+template<typename... Symbols>
+[[nodiscard]]
+auto
+eval_args(const sexpr& args,
+          const environment& env,
+          const eval_options& opts,
+          const eval_analysis_ptr& info) -> sexpr_sender {
+    // Captured by value, as with a scheduler the lambda is copied into chunks outliving this.
+    return map(
+        [env, opts, info](const sexpr& x) -> sexpr_sender {
+            return exec::just(x, env)
+                   | exec::let_value(
+                       [opts, info](const sexpr& y, const environment& e) -> sexpr_sender {
+                           return eval_impl<Symbols...>(y, e, opts, info);
+                       });
+        },
+        args,
+        opts.args);
+}
+
+/// Evaluates arguments on the thread pool, the ones with the longest critical path first.
+template<typename... Symbols>
+[[nodiscard]]
+auto
+eval_args_scheduled(const sexpr& args,
+                    const environment& env,
+                    const eval_options& opts,
+                    const eval_analysis_ptr& info) -> sexpr_sender {
+    if (not std::visit(is_list, args)) {
+        throw std::runtime_error{ "Arguments of procedure call are not a proper list!" };
+    }
+
+    const auto& sched = *opts.scheduler;
+
+    auto xs    = std::vector<sexpr>{};
+    auto paths = std::vector<double>{};
+    for (const auto& x : list_view(args)) {
+        xs.push_back(x);
+        paths.push_back(analyzed_critical_path(x, sched.costs(), *info));
+    }
+
+    auto order = std::vector<std::size_t>(xs.size());
+    std::ranges::iota(order, 0uz);
+    std::ranges::stable_sort(order, std::ranges::greater{}, [&](const auto i) { return paths[i]; });
+
+    const auto longest = paths.empty() ? 0.0 : paths[order.front()];
+
+    auto senders = std::vector<sexpr_sender>{};
+    senders.reserve(xs.size());
+    for (const auto i : order) {
+        senders.push_back(exec::schedule(sched.scheduler(sched.is_critical(paths[i], longest)))
+                          | exec::let_value([x = xs[i], env, opts, info, r = node_resource()] {
+                                const auto _ = node_resource_scope(r);
+                                return eval_impl<Symbols...>(x, env, opts, info);
+                            }));
+    }
+
+    return exec::when_all_vector(std::move(senders))
+           | exec::then([order = std::move(order),
+                         r     = node_resource()](std::vector<sexpr> ys) -> sexpr {
+                 const auto _ = node_resource_scope(r);
+                 auto in_order = std::vector<sexpr>(ys.size());
+                 for (const auto [k, i] : std::views::enumerate(order)) {
+                     in_order[i] = std::move(ys[static_cast<std::size_t>(k)]);
+                 }
+                 return list(std::from_range, in_order);
+             });
+}
+
+/// Invokes procedure and records the realized call in the scheduler.
+[[nodiscard]]
+inline auto
+invoke_scheduled(const sexpr& p,
+                 sexpr args,
+                 const critical_path_scheduler& sched,
+                 schedule_record r) -> sexpr_sender {
+    r.start = sched.now();
+    return invoke_procedure(p, std::move(args))
+           | exec::then([sched, r = std::move(r)](sexpr v) mutable -> sexpr {
+                 r.end = sched.now();
+                 sched.record(std::move(r));
+                 return v;
+             });
+}
+
+template<typename... Symbols>
+auto
+eval_impl(const sexpr& body,
+          const environment& env,
+          const eval_options& opts,
+          const eval_analysis_ptr& info) -> sexpr_sender {
     auto op = tyvi::sstd::overloaded{
         [&](const atom& x) -> sexpr_sender {
             if (atom_is_of_type<intrinsic, Symbols...>(x)) {
-                return exec::just(std::visit(assoc(x), std::visit(list_append, intrinsic_env, env))
-                                      .value()
-                                      .cdr());
+                if (const auto v = lookup_symbol(x, env)) { return exec::just(*v); }
+                throw std::runtime_error{ "Trying to eval unbound symbol!" };
             }
             return exec::just(sexpr{ x }); // Not a symbol type, i.e. it is "built-in type".
         },
         [&](const cons& c) -> sexpr_sender {
-            if (std::holds_alternative<atom>(c.car())) {
-                if (const auto intr = atom_cast<intrinsic>(std::get<atom>(c.car()))) {
-                    switch (intr.value()) {
-                        case intrinsic::quote: {
-                            if (not std::holds_alternative<cons>(c.cdr())) {
-                                throw std::runtime_error{
-                                    "Quote argument is not (one long) list!"
-                                };
-                            }
-
-                            const auto arg = std::get<cons>(c.cdr());
-
-                            if (not std::holds_alternative<null_type>(arg.cdr())) {
-                                throw std::runtime_error{
-                                    "Quote argument is not of form: (x, null)"
-                                };
-                            }
-
-                            return exec::just(arg.car());
-                        }
-                        default: break;
+            if (const auto q = quoted(c)) { return exec::just(*q); }
+
+            auto evaluate_call = [&]() -> sexpr_sender {
+                const auto* const call = info->find(c);
+                const auto synchronous = call ? call->synchronous
+                                              : is_synchronous<Symbols...>(c, env);
+
+                // Purely synchronous subtrees are evaluated inline in one sender.
+                if (synchronous) {
+                    return exec::just(c, env)
+                           | exec::then([r = node_resource()](const cons& body,
+                                                              const environment& e) -> sexpr {
+                                 const auto _ = node_resource_scope(r);
+                                 return eval_synchronous<Symbols...>(body, e);
+                             });
+                }
+
+                auto proc = eval_impl<Symbols...>(c.car(), env, opts, info);
+                auto args = opts.scheduler
+                                ? eval_args_scheduled<Symbols...>(c.cdr(), env, opts, info)
+                                : eval_args<Symbols...>(c.cdr(), env, opts, info);
+
+                const auto symbol =
+                    std::holds_alternative<atom>(c.car()) ? c.car() : sexpr{ null };
+                const auto path =
+                    opts.scheduler ? analyzed_critical_path(c, opts.scheduler->costs(), *info)
+                                   : 0.0;
+
+                auto invoke = [r = node_resource(), opts, symbol, path](const sexpr& p,
+                                                                       sexpr a) -> sexpr_sender {
+                    const auto _ = node_resource_scope(r);
+                    if (not opts.scheduler) { return invoke_procedure(p, std::move(a)); }
+
+                    return invoke_scheduled(p,
+                                            std::move(a),
+                                            *opts.scheduler,
+                                            schedule_record{ .symbol        = symbol,
+                                                             .critical_path = path,
+                                                             .start         = {},
+                                                             .end           = {} });
+                };
+
+                if constexpr (instrumentation::enabled) {
+                    if (opts.tracer) {
+                        auto started = exec::just()
+                                       | exec::then([t = *opts.tracer] { return t.now(); });
+
+                        return exec::when_all(std::move(started), std::move(proc), std::move(args))
+                               | exec::let_value([invoke, symbol, t = *opts.tracer](
+                                                     const std::chrono::nanoseconds args_start,
+                                                     const sexpr& p,
+                                                     sexpr& a) {
+                                     return t.trace(symbol, args_start, [&] {
+                                         return invoke(p, std::move(a));
+                                     });
+                                 });
                     }
                 }
-            }
 
-            auto proc = eval<Symbols...>(c.car(), env);
+                return exec::when_all(std::move(proc), std::move(args))
+                       | exec::let_value([invoke](const sexpr& p, sexpr& a) {
+                             return invoke(p, std::move(a));
+                         });
+            };
 
-            auto args = map(
-                [&](const sexpr& x) -> sexpr_sender {
-                    return exec::just(x, env)
-                           | exec::let_value([](const sexpr& y, const sexpr& e) -> sexpr_sender {
-                                 return eval<Symbols...>(y, e);
-                             });
-                },
-                c.cdr());
-
-            return exec::when_all(std::move(proc), std::move(args))
-                   | exec::let_value([](const sexpr& p, const sexpr& a) -> sexpr_sender {
-                         if (not std::holds_alternative<atom>(p)) {
-                             throw std::runtime_error{ "Trying to invoke non-procedure!" };
-                         }
-
-                         if (const auto f = atom_cast<procedure>(std::get<atom>(p))) {
-                             return std::invoke(f.value(), a);
-                         }
-                         throw std::runtime_error{ "Trying to invoke non-procedure!" };
-                     });
+            if (opts.memo) { return opts.memo->get_or_emplace(c, env, evaluate_call); }
+            return evaluate_call();
         },
         [](null_type) -> sexpr_sender { throw std::runtime_error{ "Trying to eval null!" }; }
     };
 
     return std::visit(op, body);
 }
+
+} // namespace detail
+
+template<typename... Symbols>
+auto
+eval(const sexpr& body, const environment& env, const eval_options& opts) -> sexpr_sender {
+    const auto info = detail::analyze<Symbols...>(body, env, opts);
+    return detail::eval_impl<Symbols...>(body, env, opts, info);
+}
+
+template<typename... Symbols>
+auto
+eval(const sexpr& body, const environment& env) -> sexpr_sender {
+    return eval<Symbols...>(body, env, eval_options{});
+}
+
+/// Evaluates body sharing senders of identical subexpressions through memo.
+template<typename... Symbols>
+auto
+eval(const sexpr& body, const environment& env, const memo_table& memo) -> sexpr_sender {
+    return eval<Symbols...>(body, env, eval_options{ .memo = memo });
+}
+
+/// Evaluates body in environment given as association list.
+template<typename... Symbols>
+auto
+eval(const sexpr& body, const sexpr& env) -> sexpr_sender {
+    return eval<Symbols...>(body, environment(env));
+}
+
 } // namespace tyvi::actions
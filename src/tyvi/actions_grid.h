@@ -0,0 +1,155 @@
+#pragma once
+
+#include <concepts>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "tyvi/actions_ast.h"
+#include "tyvi/actions_list.h"
+#include "tyvi/execution.h"
+#include "tyvi/mdgrid.h"
+
+namespace tyvi::actions {
+
+/// Value of grid procedures, which represents the issued mdgrid_work.
+///
+/// Passing a token as an argument to another grid procedure
+/// makes its work wait for the work of the token.
+struct work_token {
+    std::shared_ptr<const mdgrid_work> work;
+};
+
+struct grid_options {
+    /// If given, grid operations are issued in tasks on it instead of the calling thread,
+    /// so that independent operations run in parallel on the eager CPU backend.
+    std::optional<exec::thread_pool_scheduler> scheduler{};
+};
+
+namespace detail {
+
+/// Appends work_tokens found in s, which can be a token or a list possibly containing them.
+inline void
+collect_work_tokens(const sexpr& s, std::vector<std::shared_ptr<const mdgrid_work>>& works) {
+    if (const auto a = std::get_if<atom>(&s)) {
+        if (const auto t = atom_get_if<work_token>(*a)) { works.push_back(t->work); }
+        return;
+    }
+    if (not std::visit(is_list, s)) { return; }
+    for (const auto& x : list_view(s)) { collect_work_tokens(x, works); }
+}
+
+/// Issues op on a new mdgrid_work which waits for works of tokens in args.
+template<typename Op>
+[[nodiscard]]
+auto
+issue_grid_op(const Op& op, const sexpr& args) -> sexpr {
+    auto works = std::vector<std::shared_ptr<const mdgrid_work>>{};
+    collect_work_tokens(args, works);
+
+    auto w = std::make_shared<mdgrid_work>();
+    for (const auto& dep : works) { tyvi::when_all(*w, *dep); }
+    std::invoke(op, std::as_const(*w));
+
+    return work_token{ std::move(w) };
+}
+
+} // namespace detail
+
+/// Wraps operation on mdgrid_work into procedure.
+///
+/// Each invocation issues op on its own mdgrid_work (i.e. stream),
+/// so operations which do not depend on each other are not serialized.
+/// Work tokens in the arguments are the data dependencies of the operation
+/// and they are joined with when_all before op is issued.
+/// The procedure returns work_token of the issued work.
+///
+/// Grids used by op have to outlive evaluation of the program.
+template<std::invocable<const mdgrid_work&> Op>
+[[nodiscard]]
+auto
+grid_procedure(Op op, const grid_options& opts = {}) -> procedure {
+    if (not opts.scheduler) {
+        return [op = std::move(op)](sexpr args) -> sexpr_sender {
+            return exec::just(std::move(args))
+                   | exec::then([op](const sexpr& a) { return detail::issue_grid_op(op, a); });
+        };
+    }
+
+    return [op = std::move(op), sched = *opts.scheduler](sexpr args) -> sexpr_sender {
+        return exec::schedule(sched)
+               | exec::then([op, args = std::move(args), r = node_resource()] {
+                     const auto _ = node_resource_scope(r);
+                     return detail::issue_grid_op(op, args);
+                 });
+    };
+}
+
+/// Procedure which runs for_each over grid.
+template<typename MDG, typename F>
+[[nodiscard]]
+auto
+grid_for_each(MDG& mdg, F f, std::string label = {}, const grid_options& opts = {})
+    -> procedure {
+    return grid_procedure(
+        [&mdg, f = std::move(f), label = std::move(label)](const mdgrid_work& w) {
+            w.for_each(mdg, f, label);
+        },
+        opts);
+}
+
+/// Procedure which runs for_each_index over grid.
+template<typename MDG, typename F>
+[[nodiscard]]
+auto
+grid_for_each_index(MDG& mdg, F f, std::string label = {}, const grid_options& opts = {})
+    -> procedure {
+    return grid_procedure(
+        [&mdg, f = std::move(f), label = std::move(label)](const mdgrid_work& w) {
+            w.for_each_index(mdg, f, label);
+        },
+        opts);
+}
+
+/// Procedure which copies grid from device to staging buffer.
+template<typename MDG>
+[[nodiscard]]
+auto
+grid_sync_to_staging(MDG& mdg, std::string label = {}, const grid_options& opts = {})
+    -> procedure {
+    return grid_procedure([&mdg, label = std::move(label)](
+                              const mdgrid_work& w) { w.sync_to_staging(mdg, label); },
+                          opts);
+}
+
+/// Procedure which copies grid from staging to device buffer.
+template<typename MDG>
+[[nodiscard]]
+auto
+grid_sync_from_staging(MDG& mdg, std::string label = {}, const grid_options& opts = {})
+    -> procedure {
+    return grid_procedure([&mdg, label = std::move(label)](
+                              const mdgrid_work& w) { w.sync_from_staging(mdg, label); },
+                          opts);
+}
+
+/// Procedure which joins work tokens of its arguments into one.
+[[nodiscard]]
+inline auto
+grid_join() -> procedure {
+    return grid_procedure([](const mdgrid_work&) {});
+}
+
+/// Waits for all work tokens in value of a program.
+inline void
+wait_work(const sexpr& s) {
+    auto works = std::vector<std::shared_ptr<const mdgrid_work>>{};
+    detail::collect_work_tokens(s, works);
+    for (const auto& w : works) { w->wait(); }
+}
+
+} // namespace tyvi::actions
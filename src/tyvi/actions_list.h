@@ -1,14 +1,19 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
 #include <cstddef>
 #include <iterator>
+#include <optional>
 #include <ranges>
+#include <span>
+#include <stdexcept>
 #include <type_traits>
 #include <utility>
 #include <vector>
 
 #include "tyvi/actions_ast.h"
+#include "tyvi/execution.h"
 
 namespace tyvi::actions {
 
@@ -21,11 +26,13 @@ template<typename Head, typename... Tail>
     requires(not std::same_as<std::from_range_t, std::remove_cvref_t<Head>>)
 constexpr auto
 list(Head&& head, Tail&&... tail) -> sexpr {
-    if constexpr (sizeof...(Tail) == 0) {
-        return cons(std::forward<Head>(head), null);
-    } else {
-        return cons(std::forward<Head>(head), std::get<cons>(list(std::forward<Tail>(tail)...)));
+    auto elems = std::array{ sexpr(std::forward<Head>(head)), sexpr(std::forward<Tail>(tail))... };
+
+    auto current = sexpr{ null };
+    for (auto& x : elems | std::views::reverse) {
+        current = cons(std::move(x), std::move(current));
     }
+    return current;
 }
 
 constexpr auto
@@ -42,15 +49,15 @@ list(std::from_range_t, const std::ranges::bidirectional_range auto& range) -> s
 }
 
 struct is_list_closure {
-    // cppcheck-suppress functionConst
-    constexpr auto operator()(this const auto& self, const cons& c) -> bool {
-        return std::visit(self, c.cdr());
+    static constexpr auto operator()(const cons& c) -> bool {
+        auto const* x = &c.cdr();
+        while (const auto next = std::get_if<cons>(x)) { x = &next->cdr(); }
+        return std::holds_alternative<null_type>(*x);
     }
     static constexpr auto operator()(const null_type&) { return true; }
     static constexpr auto operator()(const atom&) { return false; }
 };
 
-// IDK why this can not be recursive lambda with deducing this
 constexpr auto is_list = is_list_closure{};
 
 [[nodiscard]]
@@ -71,7 +78,7 @@ class [[nodiscard]] list_iterator {
     explicit constexpr list_iterator(null_type) {}
     explicit constexpr list_iterator(const cons& list) : ptr_{ &list } {}
 
-    constexpr auto operator*() const -> value_type { return ptr_->car(); };
+    constexpr auto operator*() const -> const value_type& { return ptr_->car(); };
 
     constexpr auto operator++() -> list_iterator& {
         if (std::holds_alternative<null_type>(this->ptr_->cdr())) {
@@ -143,29 +150,93 @@ assoc(const atom& key) {
                              } };
 }
 
+struct map_options {
+    /// Number of consecutive elements joined with one when_all_vector.
+    ///
+    /// Chunks are joined pairwise into a balanced tree,
+    /// so the depth of the resulting sender is O(log(n / grain_size)).
+    std::size_t grain_size{ 16 };
+    /// If given, each chunk is started on it, so that chunks are mapped in parallel.
+    ///
+    /// In this case f and the elements are copied into the chunks.
+    std::optional<exec::thread_pool_scheduler> scheduler{};
+};
+
+namespace detail {
+
+using sexpr_vector_sender = exec::unique_any_sender<std::vector<sexpr>>;
+
+template<typename F>
 [[nodiscard]]
-constexpr auto
-map(const procedure_like auto& f, const cons& list) -> sexpr_sender {
-    if (std::holds_alternative<null_type>(list.cdr())) {
-        return std::invoke(f, list.car())
-               | exec::then([](sexpr&& x) -> sexpr { return cons(std::move(x), null); });
+auto
+map_sequence(const F& f, const std::ranges::input_range auto& xs) -> sexpr_vector_sender {
+    auto senders = std::vector<sexpr_sender>{};
+    for (const sexpr& x : xs) { senders.push_back(std::invoke(f, x)); }
+    return exec::when_all_vector(std::move(senders));
+}
+
+template<typename F>
+[[nodiscard]]
+auto
+map_balanced(const F& f, const std::span<sexpr const* const> xs, const map_options& opts)
+    -> sexpr_vector_sender {
+    if (xs.size() <= std::max(opts.grain_size, 1uz)) {
+        if (not opts.scheduler) {
+            const auto deref = [](sexpr const* const x) -> const sexpr& { return *x; };
+            return map_sequence(f, xs | std::views::transform(deref));
+        }
+
+        auto chunk = std::vector<sexpr>{};
+        chunk.reserve(xs.size());
+        for (const auto* const x : xs) { chunk.push_back(*x); }
+
+        return exec::schedule(*opts.scheduler)
+               | exec::let_value([f, chunk = std::move(chunk), r = node_resource()] {
+                     const auto _ = node_resource_scope(r);
+                     return map_sequence(f, chunk);
+                 });
     }
 
-    if (std::holds_alternative<atom>(list.cdr())) {
+    const auto mid = xs.size() / 2uz;
+    return exec::when_all(map_balanced(f, xs.first(mid), opts),
+                          map_balanced(f, xs.subspan(mid), opts))
+           | exec::then([](std::vector<sexpr> lhs, std::vector<sexpr> rhs) {
+                 lhs.insert(lhs.end(),
+                            std::make_move_iterator(rhs.begin()),
+                            std::make_move_iterator(rhs.end()));
+                 return lhs;
+             });
+}
+
+} // namespace detail
+
+/// Maps f over elements of list and joins the results into a list.
+///
+/// f is invoked for each element when the sender is constructed,
+/// unless map_options::scheduler is given, in which case it is invoked in the chunk tasks.
+/// Resulting cells are allocated from the node_resource which was bound at construction.
+[[nodiscard]]
+auto
+map(const procedure_like auto& f, const cons& list, const map_options& opts = {}) -> sexpr_sender {
+    if (not is_list(list)) {
         throw std::runtime_error{ "List given to map is not a proper list!" };
     }
 
-    return exec::when_all(std::invoke(f, list.car()), map(f, std::get<cons>(list.cdr())))
-           | exec::then([](sexpr&& head, sexpr&& tail) -> sexpr {
-                 return cons(std::move(head), std::move(tail));
+    auto xs = std::vector<sexpr const*>{};
+    for (const auto& x : list_view(list)) { xs.push_back(&x); }
+
+    return detail::map_balanced(f, xs, opts)
+           | exec::then([r = node_resource()](const std::vector<sexpr>& ys) -> sexpr {
+                 const auto _ = node_resource_scope(r);
+                 return actions::list(std::from_range, ys);
              });
 }
 
 [[nodiscard]]
-constexpr auto
-map(const procedure_like auto& f, const sexpr& s) -> sexpr_sender {
+auto
+map(const procedure_like auto& f, const sexpr& s, const map_options& opts = {}) -> sexpr_sender {
     auto op = sstd::overloaded{ [](const null_type&) -> sexpr_sender { return exec::just(null); },
-                                [&](const cons& c) { return map(f, c); },
+                                [&](const cons& c) { return map(f, c, opts); },
                                 [](const auto&) -> sexpr_sender {
                                     throw std::runtime_error{ "Can not map non-lists sexpr." };
                                 } };
@@ -184,12 +255,18 @@ struct list_append_closure {
     static constexpr auto operator()(cons lhs, auto rhs /*, Tail&&... tail*/) -> sexpr {
         if (not is_list(lhs)) { throw std::runtime_error{ "Trying to append a non-list." }; }
 
-        auto* ptr = &lhs;
-        while (std::holds_alternative<cons>(ptr->cdr())) { ptr = &std::get<cons>(*ptr->cdr_); }
-        *ptr->cdr_ = std::move(rhs);
+        // Cells are immutable, so the spine of lhs is rebuilt on top of rhs,
+        // which is shared as is.
+        auto heads = std::vector<sexpr const*>{};
+        for (const auto& x : list_view(lhs)) { heads.push_back(&x); }
+
+        auto result = sexpr{ std::move(rhs) };
+        for (const auto* const x : std::views::reverse(heads)) {
+            result = cons(*x, std::move(result));
+        }
 
         /* if (sizeof...(tail) == 0) { */
-        return lhs;
+        return result;
         /* } else {
             std::visit(list_append_closure{},
                        sexpr{ std::move(lhs) },
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+#include "tyvi/actions_ast.h"
+#include "tyvi/actions_environment.h"
+#include "tyvi/execution.h"
+#include "tyvi/sstd.h"
+
+namespace tyvi::actions {
+
+/// Shares senders of identical subexpressions (common subexpression elimination).
+///
+/// Opt-in for eval: by passing a memo table, the caller asserts
+/// that all procedures in the evaluated program are pure,
+/// i.e. identical calls give identical values and can be done only once.
+///
+/// Subexpressions are identified by their structure and the identity of their environment.
+/// Copies of the table share the same entries.
+class [[nodiscard]] memo_table {
+    using shared_sender = decltype(exec::split(std::declval<sexpr_sender>()));
+
+    /// Holds the environment, so its identity is not reused while the entry exists.
+    struct key {
+        cons expr;
+        environment env;
+
+        [[nodiscard]]
+        auto operator==(const key& other) const -> bool {
+            return env.identity() == other.env.identity() and expr == other.expr;
+        }
+    };
+
+    struct key_hash {
+        [[nodiscard]]
+        static auto operator()(const key& k) -> std::size_t {
+            const auto env_hash = std::hash<void const*>{}(k.env.identity());
+            return sstd::hash_combine(hash_value(k.expr), env_hash);
+        }
+    };
+
+    struct state {
+        std::mutex mutex;
+        std::unordered_map<key, shared_sender, key_hash> table;
+        std::size_t hits{ 0 };
+    };
+
+    std::shared_ptr<state> state_ = std::make_shared<state>();
+
+  public:
+    /// Sender of the value of expr, which is created with make when expr is seen first time.
+    ///
+    /// make is called without holding a lock, so it can use the table recursively.
+    template<std::invocable F>
+    [[nodiscard]]
+    auto get_or_emplace(const cons& expr, const environment& env, F&& make) const
+        -> sexpr_sender {
+        const auto copy = [](const sexpr& x) -> sexpr { return x; };
+        auto k          = key{ .expr = expr, .env = env };
+
+        {
+            [[maybe_unused]]
+            const std::scoped_lock _{ state_->mutex };
+            if (const auto it = state_->table.find(k); it != state_->table.end()) {
+                ++state_->hits;
+                return it->second | exec::then(copy);
+            }
+        }
+
+        auto shared = exec::split(sexpr_sender{ std::invoke(std::forward<F>(make)) });
+
+        [[maybe_unused]]
+        const std::scoped_lock _{ state_->mutex };
+        // Another thread might have inserted the same expression meanwhile.
+        const auto it = state_->table.try_emplace(std::move(k), std::move(shared)).first;
+        return it->second | exec::then(copy);
+    }
+
+    /// Number of distinct memoized subexpressions.
+    [[nodiscard]]
+    auto size() const -> std::size_t {
+        [[maybe_unused]]
+        const std::scoped_lock _{ state_->mutex };
+        return state_->table.size();
+    }
+
+    /// Number of times a memoized sender was reused.
+    [[nodiscard]]
+    auto hits() const -> std::size_t {
+        [[maybe_unused]]
+        const std::scoped_lock _{ state_->mutex };
+        return state_->hits;
+    }
+};
+
+} // namespace tyvi::actions
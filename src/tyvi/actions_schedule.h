@@ -0,0 +1,183 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "tyvi/actions_ast.h"
+#include "tyvi/actions_list.h"
+#include "tyvi/execution.h"
+
+namespace tyvi::actions {
+
+/// Costs of procedures in seconds, keyed by the symbol they are called with.
+///
+/// Measured durations take precedence over hints
+/// and they are smoothed with an exponential moving average.
+/// Copies share the same costs and all methods are thread safe.
+class [[nodiscard]] cost_model {
+    struct entry {
+        std::optional<double> hint;
+        std::optional<double> measured;
+    };
+
+    struct state {
+        std::mutex mutex;
+        std::unordered_map<atom, entry> costs;
+    };
+
+    std::shared_ptr<state> state_ = std::make_shared<state>();
+
+  public:
+    /// Cost of procedures without hint or measurement.
+    static constexpr double default_cost = 0.0;
+    /// Weight of the newest measurement in the moving average.
+    static constexpr double smoothing = 0.25;
+
+    void hint(const atom& symbol, const double seconds) const {
+        [[maybe_unused]]
+        const std::scoped_lock _{ state_->mutex };
+        state_->costs[symbol].hint = seconds;
+    }
+
+    void record(const atom& symbol, const double seconds) const {
+        [[maybe_unused]]
+        const std::scoped_lock _{ state_->mutex };
+        auto& m = state_->costs[symbol].measured;
+        m       = m ? (1.0 - smoothing) * *m + smoothing * seconds : seconds;
+    }
+
+    [[nodiscard]]
+    auto cost(const atom& symbol) const -> double {
+        [[maybe_unused]]
+        const std::scoped_lock _{ state_->mutex };
+        const auto it = state_->costs.find(symbol);
+        if (it == state_->costs.end()) { return default_cost; }
+        return it->second.measured.value_or(it->second.hint.value_or(default_cost));
+    }
+};
+
+/// Estimated duration of body with unlimited parallelism,
+/// i.e. the cost of the longest chain of procedure calls in it.
+[[nodiscard]]
+inline auto
+critical_path(const sexpr& body, const cost_model& costs) -> double {
+    const auto* const c = std::get_if<cons>(&body);
+    if (c == nullptr) { return 0.0; }
+
+    const auto& car = c->car();
+    if (std::holds_alternative<atom>(car)
+        and atom_cast<intrinsic>(std::get<atom>(car)) == intrinsic::quote) {
+        return 0.0;
+    }
+
+    const auto callee = std::holds_alternative<atom>(car) ? costs.cost(std::get<atom>(car))
+                                                          : critical_path(car, costs);
+
+    auto longest_arg = 0.0;
+    if (std::visit(is_list, c->cdr())) {
+        for (const auto& x : list_view(c->cdr())) {
+            longest_arg = std::max(longest_arg, critical_path(x, costs));
+        }
+    }
+
+    return callee + longest_arg;
+}
+
+/// One procedure call evaluated with critical_path_scheduler.
+struct schedule_record {
+    /// Symbol of the callee or null if callee was not a symbol.
+    sexpr symbol;
+    /// Critical path of the call expression when it was scheduled.
+    double critical_path;
+    /// Relative to the creation of the scheduler.
+    std::chrono::nanoseconds start;
+    /// Relative to the creation of the scheduler.
+    std::chrono::nanoseconds end;
+};
+
+/// Orders evaluation of procedure arguments by their critical path.
+///
+/// Arguments are started on the thread pool longest first
+/// and the ones close to the longest among their siblings get high priority,
+/// so that long chains are not delayed by cheap bookkeeping.
+/// Durations of calls are fed back to the cost model and recorded for inspection.
+///
+/// Copies share the cost model and the records.
+class [[nodiscard]] critical_path_scheduler {
+    struct state {
+        std::mutex mutex;
+        std::vector<schedule_record> records;
+        std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    };
+
+    cost_model costs_;
+    exec::thread_pool_scheduler scheduler_;
+    double critical_fraction_;
+    std::shared_ptr<state> state_ = std::make_shared<state>();
+
+  public:
+    /// Arguments whose critical path is at least critical_fraction of the longest are critical.
+    explicit critical_path_scheduler(cost_model costs                 = {},
+                                     exec::thread_pool_scheduler sched = {},
+                                     const double critical_fraction   = 0.9)
+        : costs_{ std::move(costs) },
+          scheduler_{ std::move(sched) },
+          critical_fraction_{ critical_fraction } {}
+
+    [[nodiscard]]
+    auto costs() const -> const cost_model& {
+        return costs_;
+    }
+
+    [[nodiscard]]
+    auto is_critical(const double path, const double longest) const -> bool {
+        return path >= critical_fraction_ * longest;
+    }
+
+    /// Scheduler on which an argument is started.
+    [[nodiscard]]
+    auto scheduler(const bool critical) const -> exec::thread_pool_scheduler {
+        const auto priority = critical ? pika::execution::thread_priority::high
+                                       : pika::execution::thread_priority::normal;
+        return exec::with_priority(scheduler_, priority);
+    }
+
+    /// Time since the creation of the scheduler.
+    [[nodiscard]]
+    auto now() const -> std::chrono::nanoseconds {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - state_->epoch);
+    }
+
+    /// Records realized call and updates the cost of its symbol.
+    void record(schedule_record r) const {
+        if (const auto a = std::get_if<atom>(&r.symbol)) {
+            costs_.record(*a, std::chrono::duration<double>(r.end - r.start).count());
+        }
+
+        [[maybe_unused]]
+        const std::scoped_lock _{ state_->mutex };
+        state_->records.push_back(std::move(r));
+    }
+
+    /// Recorded calls ordered by their start.
+    [[nodiscard]]
+    auto records() const -> std::vector<schedule_record> {
+        auto r = [&] {
+            [[maybe_unused]]
+            const std::scoped_lock _{ state_->mutex };
+            return state_->records;
+        }();
+        std::ranges::sort(r, {}, &schedule_record::start);
+        return r;
+    }
+};
+
+} // namespace tyvi::actions
@@ -0,0 +1,232 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <ranges>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "tyvi/actions_ast.h"
+#include "tyvi/execution.h"
+#include "tyvi/instrumentation.h"
+
+namespace tyvi::actions {
+
+/// One procedure call recorded by eval_tracer.
+///
+/// Times are relative to the creation of the tracer.
+struct call_record {
+    /// Symbol of the callee or null if callee was not a symbol.
+    sexpr symbol;
+    /// Evaluation of the callee and the arguments started.
+    std::chrono::nanoseconds args_start;
+    /// Arguments were ready and the procedure was invoked.
+    std::chrono::nanoseconds call_start;
+    /// Sender of the procedure completed.
+    std::chrono::nanoseconds end;
+    /// Identifies thread which invoked the procedure.
+    std::uintptr_t lane;
+};
+
+/// Aggregated calls of one symbol.
+struct symbol_profile {
+    sexpr symbol;
+    std::size_t calls;
+    /// Total time spent in evaluating arguments of the calls.
+    std::chrono::nanoseconds args_time;
+    /// Total time spent in the senders of the procedure.
+    std::chrono::nanoseconds call_time;
+    /// Average number of calls in flight, including this, when a call was invoked.
+    double mean_concurrency;
+    std::size_t max_concurrency;
+};
+
+/// Records procedure calls of eval, see eval_options::tracer.
+///
+/// Only records if tyvi is build with tyvi_ENABLE_INSTRUMENTATION,
+/// otherwise eval does not touch the tracer and this does nothing.
+/// Calls which complete with an error are not recorded.
+///
+/// Copies share the records and all methods are thread safe.
+class [[nodiscard]] eval_tracer {
+  public:
+    /// Name of symbol in exported timeline.
+    using namer = std::function<std::string(const atom&)>;
+
+  private:
+    struct state {
+        std::mutex mutex;
+        std::vector<call_record> records;
+        std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+        namer name;
+    };
+
+    std::shared_ptr<state> state_ = std::make_shared<state>();
+
+    [[nodiscard]]
+    auto name_of_(const sexpr& symbol) const -> std::string {
+        const auto a = std::get_if<atom>(&symbol);
+        if (a == nullptr) { return "procedure"; }
+        if (not state_->name) { return "symbol"; }
+        return std::invoke(state_->name, *a);
+    }
+
+  public:
+    explicit eval_tracer(namer name = {}) { state_->name = std::move(name); }
+
+    /// Time since the creation of the tracer.
+    [[nodiscard]]
+    auto now() const -> std::chrono::nanoseconds {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - state_->epoch);
+    }
+
+    void record(call_record r) const {
+        if constexpr (instrumentation::enabled) {
+            [[maybe_unused]]
+            const std::scoped_lock _{ state_->mutex };
+            state_->records.push_back(std::move(r));
+        }
+    }
+
+    /// Invokes call, i.e. the procedure of call expression, and records it when it completes.
+    template<typename F>
+    [[nodiscard]]
+    auto trace(sexpr symbol, const std::chrono::nanoseconds args_start, F&& call) const
+        -> sexpr_sender {
+        const auto lane = std::hash<std::thread::id>{}(std::this_thread::get_id());
+        auto r          = call_record{ .symbol     = std::move(symbol),
+                                       .args_start = args_start,
+                                       .call_start = now(),
+                                       .end        = {},
+                                       .lane       = lane };
+
+        return sexpr_sender{ std::invoke(std::forward<F>(call)) }
+               | exec::then([t = *this, r = std::move(r)](sexpr v) mutable -> sexpr {
+                     r.end = t.now();
+                     t.record(std::move(r));
+                     return v;
+                 });
+    }
+
+    /// Recorded calls ordered by their invocation.
+    [[nodiscard]]
+    auto records() const -> std::vector<call_record> {
+        auto r = [&] {
+            [[maybe_unused]]
+            const std::scoped_lock _{ state_->mutex };
+            return state_->records;
+        }();
+        std::ranges::sort(r, {}, &call_record::call_start);
+        return r;
+    }
+
+    /// Discards all records.
+    void clear() const {
+        [[maybe_unused]]
+        const std::scoped_lock _{ state_->mutex };
+        state_->records.clear();
+    }
+
+    /// Calls aggregated per symbol, ordered by descending total call time.
+    [[nodiscard]]
+    auto profile() const -> std::vector<symbol_profile> {
+        const auto rs = records();
+
+        auto ends = std::vector<std::chrono::nanoseconds>{};
+        ends.reserve(rs.size());
+        for (const auto& r : rs) { ends.push_back(r.end); }
+        std::ranges::sort(ends);
+
+        auto index    = std::unordered_map<sexpr, std::size_t>{};
+        auto profiles = std::vector<symbol_profile>{};
+
+        for (const auto [i, r] : std::views::enumerate(rs)) {
+            // Calls are sorted by call_start, so the calls started before this are the first i + 1.
+            const auto started  = static_cast<std::size_t>(i) + 1uz;
+            const auto finished = static_cast<std::size_t>(
+                std::ranges::distance(ends.begin(), std::ranges::upper_bound(ends, r.call_start)));
+            const auto concurrency = started - std::min(finished, started - 1uz);
+
+            const auto [it, is_new] = index.try_emplace(r.symbol, profiles.size());
+            if (is_new) {
+                profiles.push_back(symbol_profile{ .symbol           = r.symbol,
+                                                   .calls            = 0,
+                                                   .args_time        = {},
+                                                   .call_time        = {},
+                                                   .mean_concurrency = 0.0,
+                                                   .max_concurrency  = 0 });
+            }
+
+            auto& p = profiles[it->second];
+            ++p.calls;
+            p.args_time += r.call_start - r.args_start;
+            p.call_time += r.end - r.call_start;
+            p.mean_concurrency += static_cast<double>(concurrency);
+            p.max_concurrency = std::max(p.max_concurrency, concurrency);
+        }
+
+        for (auto& p : profiles) { p.mean_concurrency /= static_cast<double>(p.calls); }
+        std::ranges::sort(profiles, std::ranges::greater{}, &symbol_profile::call_time);
+        return profiles;
+    }
+
+    /// Write recorded calls in Chrome trace event format.
+    ///
+    /// Output can be opened with chrome://tracing and https://ui.perfetto.dev
+    void write_chrome_trace(std::ostream& os) const {
+        const auto as_microseconds = [](const std::chrono::nanoseconds t) {
+            return std::chrono::duration<double, std::micro>(t).count();
+        };
+
+        // Lanes are identified with small integers in the order of appearance.
+        auto lane_ids = std::map<std::uintptr_t, std::size_t>{};
+
+        auto first_event = true;
+        const auto separate = [&] {
+            if (not first_event) { os << ','; }
+            first_event = false;
+        };
+
+        os << R"({"displayTimeUnit":"ns","traceEvents":[)";
+
+        for (const auto& r : records()) {
+            const auto [lane, is_new_lane] = lane_ids.try_emplace(r.lane, lane_ids.size());
+
+            if (is_new_lane) {
+                separate();
+                os << std::format(
+                    R"({{"name":"thread_name","ph":"M","pid":0,"tid":{},)"
+                    R"("args":{{"name":"thread {}"}}}})",
+                    lane->second,
+                    lane->second);
+            }
+
+            separate();
+            os << std::format(
+                R"({{"name":"{}","cat":"call","ph":"X","pid":0,"tid":{},)"
+                R"("ts":{:.3f},"dur":{:.3f},"args":{{"args_us":{:.3f}}}}})",
+                tyvi::detail::json_escape(name_of_(r.symbol)),
+                lane->second,
+                as_microseconds(r.call_start),
+                as_microseconds(r.end - r.call_start),
+                as_microseconds(r.call_start - r.args_start));
+        }
+
+        os << "]}\n";
+    }
+};
+
+} // namespace tyvi::actions
@@ -0,0 +1,311 @@
+#include "tyvi/affinity.h"
+
+#include <algorithm>
+#include <charconv>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <optional>
+#include <ostream>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "pika/init.hpp"
+#include "pika/runtime.hpp"
+
+#include "tyvi/execution.h"
+#include "tyvi/numa.h"
+
+#if defined(__linux__)
+#    include <linux/mempolicy.h>
+#    include <pthread.h>
+#    include <sched.h>
+#    include <sys/syscall.h>
+#    include <unistd.h>
+#endif
+
+namespace {
+
+namespace taf = tyvi::affinity;
+namespace tnu = tyvi::numa;
+
+[[nodiscard]]
+auto
+getenv_view(const char* name) -> std::optional<std::string_view> {
+    const auto value = std::getenv(name);
+    if (value == nullptr) { return {}; }
+    return std::string_view(value);
+}
+
+/// Threads are left to the defaults of pika.
+[[nodiscard]]
+auto
+is_default_threading(const taf::config& cfg) -> bool {
+    return cfg.num_threads == 0 and cfg.bind == taf::binding::none;
+}
+
+/// Cpus in the order they are handed out to threads.
+[[nodiscard]]
+auto
+cpu_order(const taf::config& cfg, const std::span<const tnu::node> nodes)
+    -> std::vector<std::size_t> {
+    auto order = std::vector<std::size_t>{};
+    switch (cfg.bind) {
+        case taf::binding::none: break;
+        case taf::binding::compact:
+            for (const auto& n : nodes) {
+                order.insert(order.end(), n.cpus.begin(), n.cpus.end());
+            }
+            break;
+        case taf::binding::scatter:
+            for (auto k = 0uz;; ++k) {
+                const auto before = order.size();
+                for (const auto& n : nodes) {
+                    if (k < n.cpus.size()) { order.push_back(n.cpus[k]); }
+                }
+                if (order.size() == before) { break; }
+            }
+            break;
+        case taf::binding::list: order = cfg.cpus; break;
+    }
+    return order;
+}
+
+[[nodiscard]]
+auto
+node_of_cpu(const std::size_t cpu, const std::span<const tnu::node> nodes)
+    -> std::optional<std::size_t> {
+    for (const auto& n : nodes) {
+        if (std::ranges::contains(n.cpus, cpu)) { return n.id; }
+    }
+    return {};
+}
+
+} // namespace
+
+auto
+tyvi::affinity::to_string(const binding b) -> std::string_view {
+    switch (b) {
+        case binding::none: return "none";
+        case binding::compact: return "compact";
+        case binding::scatter: return "scatter";
+        case binding::list: return "list";
+    }
+    return "unknown";
+}
+
+auto
+tyvi::affinity::to_string(const numa_policy p) -> std::string_view {
+    switch (p) {
+        case numa_policy::inherit: return "inherit";
+        case numa_policy::local: return "local";
+        case numa_policy::interleave: return "interleave";
+    }
+    return "unknown";
+}
+
+auto
+tyvi::affinity::config_from_env(config defaults) -> config {
+    auto cfg = std::move(defaults);
+
+    if (const auto value = getenv_view("TYVI_NUM_THREADS")) {
+        auto n             = 0uz;
+        const auto [p, ec] = std::from_chars(value->data(), value->data() + value->size(), n);
+        if (ec != std::errc{} or p != value->data() + value->size()) {
+            throw std::runtime_error{ "TYVI_NUM_THREADS is not a non-negative integer!" };
+        }
+        cfg.num_threads = n;
+    }
+
+    if (const auto value = getenv_view("TYVI_BIND")) {
+        if (*value == "none") {
+            cfg.bind = binding::none;
+        } else if (*value == "compact") {
+            cfg.bind = binding::compact;
+        } else if (*value == "scatter") {
+            cfg.bind = binding::scatter;
+        } else {
+            auto cpus = numa::parse_cpulist(*value);
+            if (cpus.empty()) {
+                throw std::runtime_error{
+                    "TYVI_BIND is not none, compact, scatter or a cpu list!"
+                };
+            }
+            cfg.bind = binding::list;
+            cfg.cpus = std::move(cpus);
+        }
+    }
+
+    if (const auto value = getenv_view("TYVI_NUMA_POLICY")) {
+        if (*value == "inherit") {
+            cfg.numa = numa_policy::inherit;
+        } else if (*value == "local") {
+            cfg.numa = numa_policy::local;
+        } else if (*value == "interleave") {
+            cfg.numa = numa_policy::interleave;
+        } else {
+            throw std::runtime_error{ "TYVI_NUMA_POLICY is not inherit, local or interleave!" };
+        }
+    }
+
+    return cfg;
+}
+
+auto
+tyvi::affinity::num_threads(const config& cfg, const std::span<const numa::node> nodes)
+    -> std::size_t {
+    if (cfg.num_threads != 0) { return cfg.num_threads; }
+    if (cfg.bind == binding::list) { return cfg.cpus.size(); }
+
+    auto n = 0uz;
+    for (const auto& node : nodes) { n += node.cpus.size(); }
+    return n;
+}
+
+auto
+tyvi::affinity::plan(const config& cfg, const std::span<const numa::node> nodes)
+    -> std::vector<std::size_t> {
+    if (cfg.bind == binding::list and cfg.cpus.empty()) {
+        throw std::runtime_error{ "Binding to list of cpus requires at least one cpu!" };
+    }
+
+    const auto order = cpu_order(cfg, nodes);
+    if (order.empty()) { return {}; }
+
+    const auto n = num_threads(cfg, nodes);
+    auto cpus    = std::vector<std::size_t>(n);
+    for (auto i = 0uz; i < n; ++i) { cpus[i] = order[i % order.size()]; }
+    return cpus;
+}
+
+void
+tyvi::affinity::configure_pika(const config& cfg, pika::init_params& params) {
+    if (is_default_threading(cfg)) { return; }
+
+    params.cfg.push_back(std::format("pika.os_threads={}", num_threads(cfg)));
+
+    const auto cpus = plan(cfg);
+    if (cpus.empty()) {
+        params.cfg.emplace_back("pika.bind=none");
+        return;
+    }
+
+    auto spec = std::string{};
+    for (const auto [i, cpu] : std::views::enumerate(cpus)) {
+        if (not spec.empty()) { spec += ';'; }
+        spec += std::format("thread:{}=pu:{}", i, cpu);
+    }
+    params.cfg.push_back("pika.bind=" + spec);
+}
+
+auto
+tyvi::affinity::set_memory_policy([[maybe_unused]] const numa_policy policy) -> bool {
+#if defined(__linux__)
+    switch (policy) {
+        case numa_policy::inherit: return true;
+        case numa_policy::local:
+            return ::syscall(SYS_set_mempolicy, MPOL_LOCAL, nullptr, 0ul) == 0;
+        case numa_policy::interleave: {
+            constexpr auto bits = sizeof(unsigned long) * CHAR_BIT;
+
+            auto mask = std::vector<unsigned long>{};
+            for (const auto& n : numa::nodes()) {
+                if (n.id / bits >= mask.size()) { mask.resize(n.id / bits + 1uz); }
+                mask[n.id / bits] |= 1ul << (n.id % bits);
+            }
+            // Kernel reads maxnode - 1 bits of the mask.
+            const auto maxnode = mask.size() * bits + 1uz;
+            return ::syscall(SYS_set_mempolicy, MPOL_INTERLEAVE, mask.data(), maxnode) == 0;
+        }
+    }
+    return false;
+#else
+    return policy == numa_policy::inherit;
+#endif
+}
+
+auto
+tyvi::affinity::this_thread_cpus() -> std::vector<std::size_t> {
+    auto cpus = std::vector<std::size_t>{};
+#if defined(__linux__)
+    auto set = cpu_set_t{};
+    CPU_ZERO(&set);
+    if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) == 0) {
+        for (auto cpu = 0uz; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) { cpus.push_back(cpu); }
+        }
+    }
+#endif
+    return cpus;
+}
+
+void
+tyvi::affinity::write_report(std::ostream& os, const config& cfg) {
+    const auto& nodes = numa::nodes();
+
+    os << std::format("tyvi affinity: threads={} bind={} numa={} nodes={}\n",
+                      num_threads(cfg, nodes),
+                      to_string(cfg.bind),
+                      to_string(cfg.numa),
+                      nodes.size());
+
+    for (const auto [i, cpu] : std::views::enumerate(plan(cfg, nodes))) {
+        const auto node = node_of_cpu(cpu, nodes);
+        os << std::format("tyvi affinity: planned thread {} -> cpu {} ({})\n",
+                          i,
+                          cpu,
+                          node ? std::format("node {}", *node) : std::string{ "not available" });
+    }
+
+    os << std::format("tyvi affinity: calling thread runs on cpus {}\n",
+                      numa::format_cpulist(this_thread_cpus()));
+}
+
+auto
+tyvi::affinity::worker_cpus() -> std::vector<std::vector<std::size_t>> {
+    const auto n = pika::get_num_worker_threads();
+    auto cpus    = std::vector<std::vector<std::size_t>>(n);
+
+    const auto query = [] {
+        return std::pair{ pika::get_worker_thread_num(), this_thread_cpus() };
+    };
+
+    // Workers are queried one at a time, so that the others are less likely to steal the task.
+    for (auto i = 0uz; i < n; ++i) {
+        const auto hint  = pika::execution::thread_schedule_hint(static_cast<std::int16_t>(i));
+        const auto sched = exec::with_hint(exec::thread_pool_scheduler{}, hint);
+
+        auto [worker, c] = this_thread::sync_wait(exec::schedule(sched) | exec::then(query));
+        if (worker < n) { cpus[worker] = std::move(c); }
+    }
+    return cpus;
+}
+
+void
+tyvi::affinity::write_worker_report(std::ostream& os) {
+    for (const auto [i, cpus] : std::views::enumerate(worker_cpus())) {
+        os << std::format(
+            "tyvi affinity: worker {} runs on cpus {}\n",
+            i,
+            cpus.empty() ? std::string{ "not available" } : numa::format_cpulist(cpus));
+    }
+}
+
+void
+tyvi::affinity::init(const config& cfg, pika::init_params& params) {
+    if (not set_memory_policy(cfg.numa)) {
+        std::clog << std::format("tyvi affinity: could not set numa policy {}\n",
+                                 to_string(cfg.numa));
+    }
+    configure_pika(cfg, params);
+    write_report(std::clog, cfg);
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "tyvi/numa.h"
+
+namespace pika {
+struct init_params;
+} // namespace pika
+
+namespace tyvi::affinity {
+
+/// How threads are bound to cpus.
+enum class binding {
+    /// Threads are not pinned.
+    none,
+    /// Consecutive threads on consecutive cpus, filling one NUMA node before the next.
+    compact,
+    /// Consecutive threads round robin over the NUMA nodes.
+    scatter,
+    /// Thread i on config::cpus[i % config::cpus.size()].
+    list
+};
+
+/// Placement of memory first touched by the threads.
+enum class numa_policy {
+    /// Leave the memory policy of the process as is.
+    inherit,
+    /// Memory is placed on the node of the thread which first touches it.
+    local,
+    /// Memory is interleaved page by page over all nodes.
+    interleave
+};
+
+/// Thread count, binding and NUMA policy of the pika worker threads.
+struct config {
+    /// Zero means one thread per cpu, or per listed cpu if binding is binding::list.
+    std::size_t num_threads = 0;
+    binding bind            = binding::none;
+    /// Cpus used by binding::list.
+    std::vector<std::size_t> cpus{};
+    numa_policy numa = numa_policy::inherit;
+};
+
+/// Overrides fields of defaults from environment variables.
+///
+/// TYVI_NUM_THREADS: number of threads.
+/// TYVI_BIND: none, compact, scatter or cpu list, e.g. "0-3,8,10-11".
+/// TYVI_NUMA_POLICY: inherit, local or interleave.
+///
+/// Throws if a variable has invalid value.
+[[nodiscard]]
+auto config_from_env(config defaults = {}) -> config;
+
+/// Number of threads cfg results in.
+[[nodiscard]]
+auto num_threads(const config& cfg, std::span<const numa::node> nodes = numa::nodes())
+    -> std::size_t;
+
+/// Cpu of each thread, or empty if threads are not pinned.
+[[nodiscard]]
+auto plan(const config& cfg, std::span<const numa::node> nodes = numa::nodes())
+    -> std::vector<std::size_t>;
+
+/// Applies cfg to the pika runtime initialized with params.
+///
+/// Sets the number of worker threads and their binding.
+/// Pika interprets the cpus of the binding with its own (hwloc logical) numbering,
+/// which matches the numbering of the operating system on most machines.
+void configure_pika(const config& cfg, pika::init_params& params);
+
+/// Sets the memory policy of the calling thread,
+/// which is inherited by the threads it creates afterwards.
+///
+/// Returns false if the policy is not supported or setting it failed.
+auto set_memory_policy(numa_policy policy) -> bool;
+
+/// Cpus the calling thread is allowed to run on.
+[[nodiscard]]
+auto this_thread_cpus() -> std::vector<std::size_t>;
+
+/// Writes cfg, the planned cpu of each thread and the actual cpus of the calling thread.
+void write_report(std::ostream& os, const config& cfg);
+
+/// Cpus each pika worker thread is allowed to run on, indexed by worker.
+///
+/// Each worker is queried with a task hinted to it. The task might be stolen
+/// by another worker, in which case the cpus of the worker are not known and left empty.
+/// Has to be called while the pika runtime is running.
+[[nodiscard]]
+auto worker_cpus() -> std::vector<std::vector<std::size_t>>;
+
+/// Writes the actual cpus of each pika worker thread, see worker_cpus.
+void write_worker_report(std::ostream& os);
+
+/// Configures pika and the memory policy of the calling thread from cfg
+/// and writes the planned binding to std::clog.
+///
+/// Only the pika worker threads are bound, the calling thread is not pinned,
+/// since pika derives the cpus it may use from the mask of the process at pika::init.
+/// Work of the eager cpu backend runs on the thread that issues it,
+/// so mdgrid_work has to be issued from pika tasks, e.g. the function given to pika::init,
+/// for cfg to apply to it.
+/// tyvi::numa::run_pinned pins per NUMA node and is not affected by cfg.
+/// To be called in main before pika::init.
+/// Actual binding can be reported with write_worker_report once the runtime is running.
+void init(const config& cfg, pika::init_params& params);
+
+[[nodiscard]]
+auto to_string(binding b) -> std::string_view;
+
+[[nodiscard]]
+auto to_string(numa_policy p) -> std::string_view;
+
+} // namespace tyvi::affinity
@@ -0,0 +1,260 @@
+#include "tyvi/huge_pages.h"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <ostream>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "tyvi/sstd.h"
+
+#if defined(__linux__)
+#    include <sys/mman.h>
+#endif
+
+namespace {
+
+namespace thp = tyvi::huge_pages;
+
+constexpr auto disabled = std::numeric_limits<std::size_t>::max();
+
+/// Live huge page regions by address.
+///
+/// Number of regions is kept in an atomic,
+/// so that regular deallocations do not lock when there are no regions.
+class region_registry : tyvi::sstd::immovable {
+    std::atomic<std::size_t> threshold_{ disabled };
+    std::atomic<std::size_t> count_{ 0 };
+
+    std::mutex mutex_;
+    std::map<std::uintptr_t, thp::region> live_;
+
+  public:
+    void set_threshold(const std::optional<std::size_t> min_bytes) {
+        threshold_.store(min_bytes.value_or(disabled), std::memory_order_relaxed);
+    }
+
+    [[nodiscard]]
+    auto threshold() const -> std::size_t {
+        return threshold_.load(std::memory_order_relaxed);
+    }
+
+    void add(const thp::region r) {
+        [[maybe_unused]]
+        const std::scoped_lock _{ mutex_ };
+        live_.emplace(r.address, r);
+        count_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /// Removes region starting at p if there is one.
+    [[nodiscard]]
+    auto remove(void* const p) -> bool {
+        if (count_.load(std::memory_order_relaxed) == 0) { return false; }
+
+        [[maybe_unused]]
+        const std::scoped_lock _{ mutex_ };
+        if (live_.erase(reinterpret_cast<std::uintptr_t>(p)) == 0) { return false; }
+        count_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    [[nodiscard]]
+    auto regions() -> std::vector<thp::region> {
+        [[maybe_unused]]
+        const std::scoped_lock _{ mutex_ };
+        auto r = std::vector<thp::region>{};
+        r.reserve(live_.size());
+        for (const auto& x : live_ | std::views::values) { r.push_back(x); }
+        return r;
+    }
+};
+
+[[nodiscard]]
+region_registry&
+registry() {
+    static region_registry r{};
+    return r;
+}
+
+[[nodiscard]]
+auto
+parse_hex(const std::string_view str) -> std::optional<std::uintptr_t> {
+    auto x             = std::uintptr_t{ 0 };
+    const auto [p, ec] = std::from_chars(str.data(), str.data() + str.size(), x, 16);
+    if (ec != std::errc{} or p != str.data() + str.size()) { return {}; }
+    return x;
+}
+
+/// Parses "start-end ..." header line of a mapping in /proc/self/smaps.
+[[nodiscard]]
+auto
+parse_mapping(const std::string_view line)
+    -> std::optional<std::pair<std::uintptr_t, std::uintptr_t>> {
+    const auto range = line.substr(0, line.find(' '));
+    const auto dash  = range.find('-');
+    if (dash == std::string_view::npos) { return {}; }
+
+    const auto begin = parse_hex(range.substr(0, dash));
+    const auto end   = parse_hex(range.substr(dash + 1));
+    if (not begin or not end) { return {}; }
+    return std::pair{ *begin, *end };
+}
+
+/// Parses value of "AnonHugePages:    2048 kB" line in bytes.
+[[nodiscard]]
+auto
+parse_kib_field(std::string_view line) -> std::optional<std::size_t> {
+    line.remove_prefix(std::min(line.find(':') + 1, line.size()));
+    while (line.starts_with(' ')) { line.remove_prefix(1); }
+    line = line.substr(0, line.find(' '));
+
+    auto kib           = 0uz;
+    const auto [p, ec] = std::from_chars(line.data(), line.data() + line.size(), kib);
+    if (ec != std::errc{}) { return {}; }
+    return kib * 1024uz;
+}
+
+} // namespace
+
+namespace tyvi::huge_pages {
+
+void
+set_threshold(const std::optional<std::size_t> min_bytes) {
+    registry().set_threshold(min_bytes);
+}
+
+auto
+threshold() -> std::optional<std::size_t> {
+    const auto t = registry().threshold();
+    if (t == disabled) { return {}; }
+    return t;
+}
+
+auto
+regions() -> std::vector<region> {
+    return registry().regions();
+}
+
+auto
+allocate(const std::size_t bytes, const std::size_t alignment) -> void* {
+    if (bytes == 0uz or bytes < registry().threshold()) {
+        return ::operator new(bytes, std::align_val_t{ alignment });
+    }
+
+    // aligned_alloc requires size to be a multiple of the alignment.
+    const auto rounded = (bytes + page_size - 1uz) / page_size * page_size;
+    auto* const p      = std::aligned_alloc(std::max(page_size, alignment), rounded);
+    if (p == nullptr) { throw std::bad_alloc{}; }
+
+    // Advice has to be given before the pages are touched for the first time.
+#if defined(__linux__)
+    const auto advised = madvise(p, rounded, MADV_HUGEPAGE) == 0;
+#else
+    const auto advised = false;
+#endif
+
+    registry().add(region{ .address = reinterpret_cast<std::uintptr_t>(p),
+                           .bytes   = rounded,
+                           .advised = advised });
+    return p;
+}
+
+void
+deallocate(void* const p, const std::size_t bytes, const std::size_t alignment) noexcept {
+    if (p == nullptr) { return; }
+    if (registry().remove(p)) {
+        std::free(p);
+    } else {
+        ::operator delete(p, bytes, std::align_val_t{ alignment });
+    }
+}
+
+auto
+backed_bytes(const region& r) -> std::optional<std::size_t> {
+    auto smaps = std::ifstream("/proc/self/smaps");
+    if (not smaps) { return {}; }
+
+    const auto begin = r.address;
+    const auto end   = r.address + r.bytes;
+
+    auto found   = false;
+    auto overlap = 0uz;
+    auto backed  = 0uz;
+    auto line    = std::string{};
+    while (std::getline(smaps, line)) {
+        if (line.empty()) { continue; }
+
+        // Field names start with upper case letter and mapping addresses with lower case hex.
+        const auto is_field = line.front() >= 'A' and line.front() <= 'Z';
+        if (const auto mapping = is_field ? std::nullopt : parse_mapping(line)) {
+            const auto [b, e] = *mapping;
+            overlap = b < end and begin < e ? std::min(e, end) - std::max(b, begin) : 0uz;
+            continue;
+        }
+
+        if (overlap != 0uz and line.starts_with("AnonHugePages:")) {
+            const auto anon = parse_kib_field(line);
+            if (not anon) { return {}; }
+            // Mapping might be larger than the region, so this is an upper bound.
+            backed += std::min(*anon, overlap);
+            found = true;
+        }
+    }
+
+    if (not found) { return {}; }
+    return backed;
+}
+
+auto
+system_mode() -> std::string {
+    auto file = std::ifstream("/sys/kernel/mm/transparent_hugepage/enabled");
+    auto line = std::string{};
+    if (not std::getline(file, line)) { return {}; }
+
+    // Selected mode is in brackets, e.g. "always [madvise] never".
+    const auto open  = line.find('[');
+    const auto close = line.find(']');
+    if (open == std::string::npos or close == std::string::npos or close < open) { return {}; }
+    return line.substr(open + 1, close - open - 1);
+}
+
+void
+write_report(std::ostream& os) {
+    static constexpr auto MiB = 1024.0 * 1024.0;
+
+    const auto as_mib = [](const std::size_t bytes) { return static_cast<double>(bytes) / MiB; };
+
+    const auto mode = system_mode();
+    const auto t    = threshold();
+    os << std::format("transparent huge pages: {}, threshold: {}\n",
+                      mode.empty() ? "unknown" : mode,
+                      t ? std::format("{:.2f} MiB", as_mib(*t)) : std::string{ "disabled" });
+
+    os << std::format(
+        "{:<20} {:>14} {:>8} {:>14}\n", "address", "size [MiB]", "advised", "huge [MiB]");
+    for (const auto& r : regions()) {
+        const auto backed = backed_bytes(r);
+        os << std::format("{:<#20x} {:>14.2f} {:>8} {:>14}\n",
+                          r.address,
+                          as_mib(r.bytes),
+                          r.advised ? "yes" : "no",
+                          backed ? std::format("{:.2f}", as_mib(*backed)) : std::string{ "-" });
+    }
+}
+
+} // namespace tyvi::huge_pages
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "thrust/device_allocator.h"
+#include "thrust/memory.h"
+
+namespace tyvi::huge_pages {
+
+/// Size of transparent huge pages assumed for alignment.
+static constexpr auto page_size = std::size_t{ 2 } << 20;
+
+/// Allocations of at least min_bytes are aligned to page_size
+/// and advised to be backed by transparent huge pages.
+///
+/// Disabled by default, i.e. when min_bytes is nullopt.
+/// Only affects allocations made afterwards.
+void set_threshold(std::optional<std::size_t> min_bytes);
+
+[[nodiscard]]
+auto threshold() -> std::optional<std::size_t>;
+
+/// Allocation which was made for huge pages.
+struct region {
+    std::uintptr_t address;
+    /// Rounded up to a multiple of page_size.
+    std::size_t bytes;
+    /// False if madvise(MADV_HUGEPAGE) failed or is not supported,
+    /// in which case the region is backed by regular pages.
+    bool advised;
+};
+
+/// Live regions ordered by address.
+[[nodiscard]]
+auto regions() -> std::vector<region>;
+
+/// Bytes of r currently backed by transparent huge pages according to /proc/self/smaps.
+///
+/// Pages are backed only after they are touched, so query after initializing the data.
+/// Returns nullopt if it can not be determined.
+[[nodiscard]]
+auto backed_bytes(const region& r) -> std::optional<std::size_t>;
+
+/// Transparent huge page mode of the system (always, madvise or never), or empty if unknown.
+[[nodiscard]]
+auto system_mode() -> std::string;
+
+/// Write human readable table of the live regions and how much of them are backed by huge pages.
+void write_report(std::ostream& os);
+
+/// Allocates bytes aligned to at least alignment.
+///
+/// If bytes is at least threshold(), the allocation is a huge page region.
+/// Throws std::bad_alloc if the allocation fails.
+[[nodiscard]]
+auto allocate(std::size_t bytes, std::size_t alignment) -> void*;
+
+/// Deallocates memory given by allocate.
+void deallocate(void* p, std::size_t bytes, std::size_t alignment) noexcept;
+
+/// Standard allocator using tyvi::huge_pages::allocate.
+template<typename T>
+struct allocator {
+    using value_type = T;
+
+    allocator() = default;
+
+    template<typename U>
+    explicit(false) constexpr allocator(const allocator<U>&) noexcept {}
+
+    [[nodiscard]]
+    auto allocate(const std::size_t n) -> T* {
+        return static_cast<T*>(huge_pages::allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* const p, const std::size_t n) noexcept {
+        huge_pages::deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    template<typename U>
+    friend constexpr auto operator==(const allocator&, const allocator<U>&) -> bool {
+        return true;
+    }
+};
+
+/// Allocator of thrust device vectors using tyvi::huge_pages::allocate.
+///
+/// Only meaningful for the cpu backend, where device memory is host memory.
+template<typename T>
+struct device_allocator : thrust::device_allocator<T> {
+    using base      = thrust::device_allocator<T>;
+    using pointer   = typename base::pointer;
+    using size_type = typename base::size_type;
+
+    template<typename U>
+    struct rebind {
+        using other = device_allocator<U>;
+    };
+
+    device_allocator() = default;
+
+    template<typename U>
+    explicit(false) device_allocator(const device_allocator<U>&) noexcept {}
+
+    [[nodiscard]]
+    auto allocate(const size_type n) -> pointer {
+        return pointer(static_cast<T*>(huge_pages::allocate(n * sizeof(T), alignof(T))));
+    }
+
+    void deallocate(const pointer p, const size_type n) noexcept {
+        huge_pages::deallocate(thrust::raw_pointer_cast(p), n * sizeof(T), alignof(T));
+    }
+};
+
+} // namespace tyvi::huge_pages
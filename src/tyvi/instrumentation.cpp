@@ -0,0 +1,355 @@
+#include "tyvi/instrumentation.h"
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "tyvi/backend.h"
+#include "tyvi/mdgrid.h"
+
+namespace {
+
+namespace ti = tyvi::instrumentation;
+
+#if defined(TYVI_ENABLE_INSTRUMENTATION)
+
+struct pending_record {
+    std::string label;
+    ti::operation op;
+    std::size_t bytes;
+    std::uintptr_t lane;
+#    if defined(TYVI_BACKEND_CPU)
+    std::chrono::steady_clock::time_point start, end;
+#    elif defined(TYVI_BACKEND_HIP)
+    hipEvent_t start, end;
+#    else
+    static_assert(false, "Unregonized backend!");
+#    endif
+};
+
+class trace_registry : tyvi::sstd::immovable {
+    std::mutex mutex_;
+    std::deque<pending_record> pending_;
+    std::size_t max_records_{ ti::default_max_records };
+
+    static void discard_([[maybe_unused]] const pending_record& r) {
+#    if defined(TYVI_BACKEND_HIP)
+        // Events may still be recording, which hipEventDestroy allows.
+        std::ignore = hipEventDestroy(r.start);
+        std::ignore = hipEventDestroy(r.end);
+#    endif
+    }
+
+    /// Assumes that mutex_ is locked.
+    void trim_() {
+        while (pending_.size() > max_records_) {
+            discard_(pending_.front());
+            pending_.pop_front();
+        }
+    }
+
+#    if defined(TYVI_BACKEND_CPU)
+    std::chrono::steady_clock::time_point origin_{ std::chrono::steady_clock::now() };
+
+    void restart_() { origin_ = std::chrono::steady_clock::now(); }
+
+    [[nodiscard]]
+    auto resolve_(const pending_record& r) const -> ti::kernel_record {
+        return { .label = r.label,
+                 .op    = r.op,
+                 .start = r.start - origin_,
+                 .end   = r.end - origin_,
+                 .bytes = r.bytes,
+                 .lane  = r.lane };
+    }
+#    elif defined(TYVI_BACKEND_HIP)
+    hipEvent_t origin_{};
+
+    void restart_() { tyvi::detail::hip_check_error(hipEventRecord(origin_, nullptr)); }
+
+    [[nodiscard]]
+    auto resolve_(const pending_record& r) const -> ti::kernel_record {
+        tyvi::detail::hip_check_error(hipEventSynchronize(r.end));
+
+        float start_ms{}, end_ms{};
+        tyvi::detail::hip_check_error(hipEventElapsedTime(&start_ms, origin_, r.start));
+        tyvi::detail::hip_check_error(hipEventElapsedTime(&end_ms, origin_, r.end));
+
+        const auto as_ns = [](const float ms) {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::duration<float, std::milli>(ms));
+        };
+
+        return { .label = r.label,
+                 .op    = r.op,
+                 .start = as_ns(start_ms),
+                 .end   = as_ns(end_ms),
+                 .bytes = r.bytes,
+                 .lane  = r.lane };
+    }
+#    else
+    static_assert(false, "Unregonized backend!");
+#    endif
+
+  public:
+    trace_registry() {
+#    if defined(TYVI_BACKEND_HIP)
+        tyvi::detail::hip_check_error(hipEventCreate(&origin_));
+        restart_();
+#    endif
+    }
+
+    // Registry lives until the end of the program,
+    // when the hip runtime might already be gone, so hip events are not destroyed.
+    ~trace_registry() = default;
+
+    void push(pending_record r) {
+        [[maybe_unused]]
+        const std::scoped_lock _{ mutex_ };
+        pending_.push_back(std::move(r));
+        trim_();
+    }
+
+    void set_max_records(const std::size_t n) {
+        [[maybe_unused]]
+        const std::scoped_lock _{ mutex_ };
+        max_records_ = n;
+        trim_();
+    }
+
+    [[nodiscard]]
+    auto records() -> std::vector<ti::kernel_record> {
+        [[maybe_unused]]
+        const std::scoped_lock _{ mutex_ };
+
+#    if defined(TYVI_BACKEND_HIP)
+        tyvi::detail::hip_check_error(hipEventSynchronize(origin_));
+#    endif
+
+        auto result = std::vector<ti::kernel_record>{};
+        result.reserve(pending_.size());
+        for (const auto& r : pending_) { result.push_back(resolve_(r)); }
+        return result;
+    }
+
+    void clear() {
+        [[maybe_unused]]
+        const std::scoped_lock _{ mutex_ };
+
+        for (const auto& r : pending_) { discard_(r); }
+        pending_.clear();
+        restart_();
+    }
+};
+
+[[nodiscard]]
+trace_registry&
+registry() {
+    static trace_registry r{};
+    return r;
+}
+
+#endif
+
+[[nodiscard]]
+auto
+as_microseconds(const std::chrono::nanoseconds t) -> double {
+    return std::chrono::duration<double, std::micro>(t).count();
+}
+
+} // namespace
+
+namespace tyvi::instrumentation {
+
+auto
+records() -> std::vector<kernel_record> {
+#if defined(TYVI_ENABLE_INSTRUMENTATION)
+    return registry().records();
+#else
+    return {};
+#endif
+}
+
+void
+clear() {
+#if defined(TYVI_ENABLE_INSTRUMENTATION)
+    registry().clear();
+#endif
+}
+
+void
+set_max_records([[maybe_unused]] const std::size_t n) {
+#if defined(TYVI_ENABLE_INSTRUMENTATION)
+    registry().set_max_records(n);
+#endif
+}
+
+void
+write_chrome_trace(std::ostream& os) {
+    static constexpr auto lane_kind = active_backend == backend::hip
+                                          ? std::string_view{ "stream" }
+                                          : std::string_view{ "thread" };
+
+    // Lanes are identified with small integers in the order of appearance.
+    auto lane_ids = std::map<std::uintptr_t, std::size_t>{};
+
+    auto first_event = true;
+    const auto separate = [&] {
+        if (not first_event) { os << ','; }
+        first_event = false;
+    };
+
+    os << R"({"displayTimeUnit":"ns","traceEvents":[)";
+
+    for (const auto& r : records()) {
+        const auto [lane, is_new_lane] = lane_ids.try_emplace(r.lane, lane_ids.size());
+
+        if (is_new_lane) {
+            separate();
+            os << std::format(
+                R"({{"name":"thread_name","ph":"M","pid":0,"tid":{},"args":{{"name":"{} {}"}}}})",
+                lane->second,
+                lane_kind,
+                lane->second);
+        }
+
+        separate();
+        os << std::format(
+            R"({{"name":"{}","cat":"{}","ph":"X","pid":0,"tid":{},)"
+            R"("ts":{:.3f},"dur":{:.3f},"args":{{"bytes":{}}}}})",
+            tyvi::detail::json_escape(r.label),
+            to_string(r.op),
+            lane->second,
+            as_microseconds(r.start),
+            as_microseconds(r.end - r.start),
+            r.bytes);
+    }
+
+    os << "]}\n";
+}
+
+void
+write_chrome_trace(const std::filesystem::path& path) {
+    auto file = std::ofstream(path);
+    if (not file) {
+        throw std::runtime_error{ std::format("Could not open {} for writing.", path.string()) };
+    }
+    write_chrome_trace(file);
+}
+
+} // namespace tyvi::instrumentation
+
+#if defined(TYVI_ENABLE_INSTRUMENTATION)
+#    if defined(TYVI_BACKEND_CPU)
+
+tyvi::detail::work_scope::work_scope(const std::string_view label,
+                                     const instrumentation::operation op,
+                                     const std::size_t bytes)
+    : label_{ label },
+      op_{ op },
+      bytes_{ bytes } {
+    // Makes sure that the origin of the trace is taken before this.
+    std::ignore = registry();
+    start_      = std::chrono::steady_clock::now();
+#        if defined(TYVI_ENABLE_PERF_COUNTERS)
+    // Read last, so that the setup is not counted.
+    counters_ = read_counters();
+#        endif
+}
+
+tyvi::detail::work_scope::~work_scope() {
+#        if defined(TYVI_ENABLE_PERF_COUNTERS)
+    // Read first, so that the recording is not counted.
+    const auto counters = read_counters();
+#        endif
+    const auto end  = std::chrono::steady_clock::now();
+    const auto lane = std::hash<std::thread::id>{}(std::this_thread::get_id());
+
+    const auto label = label_.empty() ? to_string(op_) : label_;
+
+#        if defined(TYVI_ENABLE_PERF_COUNTERS)
+    record_counters(label, bytes_, end - start_, counters_, counters);
+#        endif
+
+    registry().push({ .label = std::string{ label },
+                      .op    = op_,
+                      .bytes = bytes_,
+                      .lane  = static_cast<std::uintptr_t>(lane),
+                      .start = start_,
+                      .end   = end });
+}
+
+#    elif defined(TYVI_BACKEND_HIP)
+
+tyvi::detail::work_scope::work_scope(const std::string_view label,
+                                     const instrumentation::operation op,
+                                     const std::size_t bytes,
+                                     hipStream_t stream)
+    : label_{ label },
+      op_{ op },
+      bytes_{ bytes },
+      stream_{ stream } {
+    // Makes sure that the origin of the trace is recorded before this.
+    std::ignore = registry();
+
+    hip_check_error(hipEventCreate(&start_));
+    hip_check_error(hipEventRecord(start_, stream_));
+}
+
+tyvi::detail::work_scope::~work_scope() {
+    hipEvent_t end{};
+    // Errors can not be reported from destructor, so they are ignored.
+    // In that case, the operation is not recorded.
+    if (hipEventCreate(&end) != hipSuccess or hipEventRecord(end, stream_) != hipSuccess) {
+        std::ignore = hipEventDestroy(start_);
+        return;
+    }
+
+    const auto label = label_.empty() ? to_string(op_) : label_;
+
+    registry().push({ .label = std::string{ label },
+                      .op    = op_,
+                      .bytes = bytes_,
+                      .lane  = reinterpret_cast<std::uintptr_t>(stream_),
+                      .start = start_,
+                      .end   = end });
+}
+
+#    else
+static_assert(false, "Unregonized backend!");
+#    endif
+#endif
+
+auto
+tyvi::detail::json_escape(const std::string_view str) -> std::string {
+    auto escaped = std::string{};
+    escaped.reserve(str.size());
+
+    for (const auto c : str) {
+        switch (c) {
+            case '"': escaped += "\\\""; break;
+            case '\\': escaped += "\\\\"; break;
+            case '\n': escaped += "\\n"; break;
+            case '\t': escaped += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    escaped += std::format("\\u{:04x}", static_cast<unsigned>(c));
+                } else {
+                    escaped += c;
+                }
+        }
+    }
+    return escaped;
+}
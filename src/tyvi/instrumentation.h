@@ -0,0 +1,165 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#if defined(TYVI_BACKEND_CPU)
+#elif defined(TYVI_BACKEND_HIP)
+#    include "hip/hip_runtime.h"
+#else
+static_assert(false, "Unregonized backend!");
+#endif
+
+#include "tyvi/perf_counters.h"
+#include "tyvi/sstd.h"
+
+namespace tyvi::instrumentation {
+
+/// True if tyvi is build with tyvi_ENABLE_INSTRUMENTATION.
+#if defined(TYVI_ENABLE_INSTRUMENTATION)
+static constexpr bool enabled = true;
+#else
+static constexpr bool enabled = false;
+#endif
+
+/// Kind of mdgrid_work operation.
+enum class operation : std::uint8_t {
+    for_each,
+    for_each_index,
+    sync_to_staging,
+    sync_from_staging,
+    when_all
+};
+
+[[nodiscard]]
+constexpr auto
+to_string(const operation op) -> std::string_view {
+    switch (op) {
+        case operation::for_each: return "for_each";
+        case operation::for_each_index: return "for_each_index";
+        case operation::sync_to_staging: return "sync_to_staging";
+        case operation::sync_from_staging: return "sync_from_staging";
+        case operation::when_all: return "when_all";
+    }
+    std::unreachable();
+}
+
+/// One recorded mdgrid_work operation.
+struct kernel_record {
+    /// User given label or name of the operation if no label was given.
+    std::string label;
+    operation op;
+    /// Relative to the start of the trace.
+    std::chrono::nanoseconds start;
+    /// Relative to the start of the trace.
+    std::chrono::nanoseconds end;
+    /// Amount of grid data the operation touches.
+    std::size_t bytes;
+    /// Identifies thread (cpu backend) or stream (hip backend) which executed the operation.
+    std::uintptr_t lane;
+};
+
+/// Get all operations recorded since the start of the trace.
+///
+/// On hip backend timestamps are measured on device,
+/// so this waits for the recorded operations to finish.
+///
+/// Always empty if instrumentation is disabled.
+[[nodiscard]]
+auto records() -> std::vector<kernel_record>;
+
+/// Discard all recorded operations and restart the trace.
+void clear();
+
+/// Number of recorded operations kept by default, see set_max_records.
+static constexpr std::size_t default_max_records = 1uz << 20;
+
+/// Keep at most n recorded operations, discarding the oldest ones first.
+///
+/// Each kept operation holds its label and, on hip backend, two hip events,
+/// so the memory of the trace is bounded by n until clear is called.
+void set_max_records(std::size_t n);
+
+/// Write recorded operations in Chrome trace event format.
+///
+/// Output can be opened with chrome://tracing and https://ui.perfetto.dev
+void write_chrome_trace(std::ostream& os);
+
+/// Write recorded operations in Chrome trace event format to given file.
+void write_chrome_trace(const std::filesystem::path& path);
+
+} // namespace tyvi::instrumentation
+
+namespace tyvi::detail {
+
+#if defined(TYVI_ENABLE_INSTRUMENTATION)
+/// Records mdgrid_work operation which is issued during the lifetime of the scope.
+///
+/// If tyvi is build with tyvi_ENABLE_PERF_COUNTERS,
+/// hardware counters of the calling thread are sampled as well.
+///
+/// Given label has to outlive the scope.
+class [[nodiscard]] work_scope : sstd::immovable {
+    std::string_view label_;
+    instrumentation::operation op_;
+    std::size_t bytes_;
+#    if defined(TYVI_BACKEND_CPU)
+    std::chrono::steady_clock::time_point start_;
+#        if defined(TYVI_ENABLE_PERF_COUNTERS)
+    counter_snapshot counters_;
+#        endif
+#    elif defined(TYVI_BACKEND_HIP)
+    hipStream_t stream_;
+    hipEvent_t start_{};
+#    else
+    static_assert(false, "Unregonized backend!");
+#    endif
+
+  public:
+#    if defined(TYVI_BACKEND_CPU)
+    explicit work_scope(std::string_view label, instrumentation::operation op, std::size_t bytes);
+#    elif defined(TYVI_BACKEND_HIP)
+    explicit work_scope(std::string_view label,
+                        instrumentation::operation op,
+                        std::size_t bytes,
+                        hipStream_t stream);
+#    else
+    static_assert(false, "Unregonized backend!");
+#    endif
+
+    ~work_scope();
+};
+#else
+/// Instrumentation is disabled, so this does nothing.
+struct [[nodiscard]] work_scope {
+    constexpr explicit work_scope(auto&&...) noexcept {}
+};
+#endif
+
+/// Escapes str to be used inside of JSON string.
+[[nodiscard]]
+auto json_escape(std::string_view str) -> std::string;
+
+/// Amount of data in the elements of given grid mdspan.
+template<typename MDS>
+[[nodiscard]]
+constexpr auto
+touched_bytes(const MDS& mds) -> std::size_t {
+    using element_mds     = typename MDS::value_type;
+    using element_extents = typename element_mds::extents_type;
+
+    const auto element_size = []<std::size_t... I>(std::index_sequence<I...>) {
+        return (1uz * ... * element_extents::static_extent(I));
+    }(std::make_index_sequence<element_extents::rank()>());
+
+    return mds.size() * element_size * sizeof(typename element_mds::value_type);
+}
+
+} // namespace tyvi::detail
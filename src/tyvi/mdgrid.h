@@ -1,13 +1,21 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <concepts>
 #include <cstddef>
 #include <deque>
+#include <format>
 #include <future>
 #include <mutex>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 #include <tuple>
 #include <utility>
+#include <vector>
 
 #include "thrust/copy.h"
 #include "thrust/device_vector.h"
@@ -23,8 +31,12 @@ static_assert(false, "Unregonized backend!");
 #endif
 
 #include "tyvi/backend.h"
+#include "tyvi/execution.h"
+#include "tyvi/huge_pages.h"
+#include "tyvi/instrumentation.h"
 #include "tyvi/mdgrid_buffer.h"
 #include "tyvi/mdspan.h"
+#include "tyvi/memory_registry.h"
 #include "tyvi/sstd.h"
 
 namespace tyvi {
@@ -39,6 +51,18 @@ struct mdgrid_element_descriptor {
 
 class mdgrid_work;
 
+/// Contiguous part of a staging buffer given by mdgrid_work::sync_to_staging_chunked.
+///
+/// Buffers are component-major, so component c of the elements of a grid with n points
+/// is at [c * n, (c + 1) * n) of the buffer and a slab might span several components.
+template<typename T>
+struct staging_slab {
+    std::size_t index;
+    /// Offset of the first value of data in the staging buffer.
+    std::size_t offset;
+    std::span<T> data;
+};
+
 template<auto ElemDesc, typename GridExtents, typename GridLayoutPolicy = std::layout_right>
 class [[nodiscard]]
 mdgrid {
@@ -66,19 +90,78 @@ mdgrid {
                                          grid_layout_type>;
 
   private:
-    device_buffer device_buff_;
-    staging_buffer staging_buff_;
+#if defined(TYVI_BACKEND_CPU)
+    /// Device memory is host memory, so both buffers can be backed by huge pages.
+    using device_storage_vec =
+        thrust::device_vector<value_type, huge_pages::device_allocator<value_type>>;
+    using staging_storage_vec = thrust::host_vector<value_type, huge_pages::allocator<value_type>>;
+#else
+    using device_storage_vec  = device_vec;
+    using staging_storage_vec = staging_vec;
+#endif
+
+    using device_storage = mdgrid_buffer<device_storage_vec,
+                                         element_extents_type,
+                                         element_layout_type,
+                                         grid_extents_type,
+                                         grid_layout_type>;
+
+    using staging_storage = mdgrid_buffer<staging_storage_vec,
+                                          element_extents_type,
+                                          element_layout_type,
+                                          grid_extents_type,
+                                          grid_layout_type>;
+
+    device_storage device_buff_;
+    staging_storage staging_buff_;
+    detail::memory_registration memory_;
 
     friend class mdgrid_work;
 
+    [[nodiscard]]
+    constexpr memory::usage held_bytes_() {
+        return { .device_bytes  = device_buff_.span().size_bytes(),
+                 .staging_bytes = staging_buff_.span().size_bytes() };
+    }
+
+    /// Moves buff into storage if it is of the storage type,
+    /// otherwise copies it into the existing storage after checking its length.
+    template<typename Storage, typename Buff>
+    static constexpr void set_storage_buffer_(Storage& storage, Buff&& buff) {
+        if constexpr (requires { storage.set_underlying_buffer(std::forward<Buff>(buff)); }) {
+            storage.set_underlying_buffer(std::forward<Buff>(buff));
+        } else {
+            const auto my_size    = storage.span().size();
+            const auto other_size = std::ranges::size(buff);
+
+            if (my_size != other_size) {
+                throw std::invalid_argument{
+                    std::format("Expected {} sized buffer, got: {}", my_size, other_size)
+                };
+            }
+
+            thrust::copy(std::ranges::begin(buff), std::ranges::end(buff), storage.begin());
+        }
+    }
+
   public:
     explicit constexpr mdgrid(const auto... grid_extents)
         : device_buff_(grid_extents...),
-          staging_buff_(grid_extents...) {}
+          staging_buff_(grid_extents...),
+          memory_(held_bytes_()) {}
 
     explicit constexpr mdgrid(const grid_extents_type& grid_extents)
         : device_buff_(grid_extents),
-          staging_buff_(grid_extents) {}
+          staging_buff_(grid_extents),
+          memory_(held_bytes_()) {}
+
+    /// Name used for this grid in tyvi::memory reports.
+    constexpr void set_name(std::string name) { memory_.set_name(std::move(name)); }
+
+    [[nodiscard]]
+    constexpr std::string name() const {
+        return memory_.name();
+    }
 
     [[nodiscard]]
     constexpr auto mds() & {
@@ -132,13 +215,13 @@ mdgrid {
     /// Get copy of the underlying data buffer from staging buffer.
     [[nodiscard]]
     constexpr staging_vec underlying_staging_buffer() const {
-        return staging_buff_.underlying_buffer();
+        return staging_vec(staging_buff_.begin(), staging_buff_.end());
     }
 
     /// Get copy of the underlying data buffer.
     [[nodiscard]]
     constexpr device_vec underlying_buffer() const {
-        return device_buff_.underlying_buffer();
+        return device_vec(device_buff_.begin(), device_buff_.end());
     }
 
     /// Set the underlying data buffer in staging buffer.
@@ -146,11 +229,13 @@ mdgrid {
     /// Invalidates all pointers. This includes pointers in [md]span.
     ///
     /// Constraints are checked in mdgrid_buffer method.
+    /// Buffers of other type than the storage, e.g. staging_vec with the cpu backend,
+    /// are copied into the existing storage instead of being moved in.
     ///
     /// Throws if the given buffer is not the same legth as
     /// the one it replaces.
     constexpr void set_underlying_staging_buffer(auto&& buff) {
-        staging_buff_.set_underlying_buffer(std::forward<decltype(buff)>(buff));
+        set_storage_buffer_(staging_buff_, std::forward<decltype(buff)>(buff));
     }
 
     /// Set the underlying data buffer.
@@ -159,16 +244,19 @@ mdgrid {
     /// This includes pointers in [md]span.
     ///
     /// Constraints are checked in mdgrid_buffer method.
+    /// Buffers of other type than the storage, e.g. device_vec with the cpu backend,
+    /// are copied into the existing storage instead of being moved in.
     ///
     /// Throws if the given buffer is not the same legth as
     /// the one it replaces.
     constexpr void set_underlying_buffer(auto&& buff) {
-        device_buff_.set_underlying_buffer(std::forward<decltype(buff)>(buff));
+        set_storage_buffer_(device_buff_, std::forward<decltype(buff)>(buff));
     }
 
     constexpr void invalidating_resize(const grid_extents_type& extents) {
         staging_buff_.invalidating_resize(extents);
         device_buff_.invalidating_resize(extents);
+        memory_.update(held_bytes_());
     }
 
     template<typename... Indices>
@@ -287,7 +375,22 @@ class mdgrid_work {
 
     template<std::same_as<mdgrid_work>... T>
         requires(sizeof...(T) != 0)
-    friend void when_all(const T&... w);
+    friend void when_all(std::string_view label, const T&... w);
+
+    [[nodiscard]]
+    detail::work_scope trace_([[maybe_unused]] const std::string_view label,
+                              [[maybe_unused]] const instrumentation::operation op,
+                              [[maybe_unused]] const std::size_t bytes) const {
+#if !defined(TYVI_ENABLE_INSTRUMENTATION)
+        return detail::work_scope{};
+#elif defined(TYVI_BACKEND_CPU)
+        return detail::work_scope(label, op, bytes);
+#elif defined(TYVI_BACKEND_HIP)
+        return detail::work_scope(label, op, bytes, handle_.get());
+#else
+        static_assert(false, "Unregonized backend!");
+#endif
+    }
 
   public:
     [[nodiscard]]
@@ -303,11 +406,16 @@ class mdgrid_work {
 
     // NOLINTBEGIN{modernize-use-nodiscard}
 
+    /// Label is optional and only used if tyvi is build with tyvi_ENABLE_INSTRUMENTATION.
     template<typename MDG, typename F>
-    const mdgrid_work& for_each(MDG& mdg, F f) const {
-        auto grid_mds  = mdg.device_buff_.mds();
+    const mdgrid_work& for_each(MDG& mdg, F f, const std::string_view label = {}) const {
+        auto grid_mds  = mdg.mds();
         auto wrapped_f = [grid_mds, f = std::move(f)](const auto& idx) { f(grid_mds[idx]); };
 
+        [[maybe_unused]]
+        const auto scope =
+            trace_(label, instrumentation::operation::for_each, detail::touched_bytes(grid_mds));
+
 #if defined(TYVI_BACKEND_CPU)
         constexpr auto Rank = std::remove_cvref_t<decltype(grid_mds)>::rank();
         using idx_t         = typename std::remove_cvref_t<decltype(grid_mds)>::index_type;
@@ -327,12 +435,19 @@ class mdgrid_work {
         return *this;
     }
 
+    /// Label is optional and only used if tyvi is build with tyvi_ENABLE_INSTRUMENTATION.
     template<typename T, typename E, typename LP, typename AP, typename F>
-    const mdgrid_work& for_each_index(const std::mdspan<T, E, LP, AP>& mds, F f) const {
+    const mdgrid_work& for_each_index(const std::mdspan<T, E, LP, AP>& mds,
+                                      F f,
+                                      const std::string_view label = {}) const {
         using MDS = std::mdspan<T, E, LP, AP>;
 
         const auto indices = sstd::index_space(mds);
 
+        [[maybe_unused]]
+        const auto scope =
+            trace_(label, instrumentation::operation::for_each_index, detail::touched_bytes(mds));
+
         using grid_indices_range = decltype(indices);
         using element_indices_range =
             decltype(sstd::index_space(std::declval<typename MDS::value_type>()));
@@ -386,13 +501,20 @@ class mdgrid_work {
         return *this;
     }
 
+    /// Label is optional and only used if tyvi is build with tyvi_ENABLE_INSTRUMENTATION.
     template<typename MDG, typename F>
-    const mdgrid_work& for_each_index(MDG& mdg, F f) const {
-        return for_each_index(mdg.device_buff_.mds(), std::move(f));
+    const mdgrid_work& for_each_index(MDG& mdg, F f, const std::string_view label = {}) const {
+        return for_each_index(mdg.mds(), std::move(f), label);
     }
 
+    /// Label is optional and only used if tyvi is build with tyvi_ENABLE_INSTRUMENTATION.
     template<typename MDG>
-    const mdgrid_work& sync_to_staging(MDG& mdg) const {
+    const mdgrid_work& sync_to_staging(MDG& mdg, const std::string_view label = {}) const {
+        [[maybe_unused]]
+        const auto scope = trace_(label,
+                                  instrumentation::operation::sync_to_staging,
+                                  detail::touched_bytes(mdg.device_buff_.mds()));
+
 #if defined(TYVI_BACKEND_CPU)
         thrust::copy(thrust::device,
                      mdg.device_buff_.begin(),
@@ -410,8 +532,14 @@ class mdgrid_work {
         return *this;
     }
 
+    /// Label is optional and only used if tyvi is build with tyvi_ENABLE_INSTRUMENTATION.
     template<typename MDG>
-    const mdgrid_work& sync_from_staging(MDG& mdg) const {
+    const mdgrid_work& sync_from_staging(MDG& mdg, const std::string_view label = {}) const {
+        [[maybe_unused]]
+        const auto scope = trace_(label,
+                                  instrumentation::operation::sync_from_staging,
+                                  detail::touched_bytes(mdg.device_buff_.mds()));
+
 #if defined(TYVI_BACKEND_CPU)
         thrust::copy(thrust::device,
                      mdg.staging_buff_.begin(),
@@ -428,6 +556,117 @@ class mdgrid_work {
         return *this;
     }
 
+    /// Same as sync_to_staging, but the buffer is copied in num_slabs contiguous slabs
+    /// and on_slab(staging_slab<const value_type>) is called for each slab once it has arrived.
+    ///
+    /// on_slab is called on the calling thread and host processing of slab k
+    /// overlaps the copy of the following slabs.
+    /// With the hip backend all slabs are issued in order after the work issued so far,
+    /// each followed by an event, and on_slab is called as the events complete.
+    /// With the cpu backend the slabs are copied by tasks on the pika thread pool,
+    /// slab k + 1 being copied while on_slab is called for slab k,
+    /// so the pika runtime has to be running.
+    /// Returns after on_slab has been called for all slabs.
+    /// If on_slab throws, it is not called for the remaining slabs and the exception is rethrown.
+    ///
+    /// Label is optional and only used if tyvi is build with tyvi_ENABLE_INSTRUMENTATION.
+    template<typename MDG, typename F>
+    const mdgrid_work& sync_to_staging_chunked(MDG& mdg,
+                                               const std::size_t num_slabs,
+                                               F on_slab,
+                                               const std::string_view label = {}) const {
+        [[maybe_unused]]
+        const auto scope = trace_(label,
+                                  instrumentation::operation::sync_to_staging,
+                                  detail::touched_bytes(mdg.device_buff_.mds()));
+
+        const auto staging = std::as_const(mdg.staging_buff_).span();
+        const auto n       = staging.size();
+        const auto slabs   = std::clamp(num_slabs, 1uz, std::max(n, 1uz));
+        const auto bound   = [&](const std::size_t k) { return k * n / slabs; };
+        const auto at      = [&](auto& buff, const std::size_t k) {
+            return buff.begin() + static_cast<std::ptrdiff_t>(bound(k));
+        };
+
+        const auto copy_slab = [&](const std::size_t k) {
+            const auto first = at(mdg.device_buff_, k);
+            const auto last  = at(mdg.device_buff_, k + 1uz);
+            const auto dest  = at(mdg.staging_buff_, k);
+#if defined(TYVI_BACKEND_CPU)
+            thrust::copy(thrust::device, first, last, dest);
+#elif defined(TYVI_BACKEND_HIP)
+            thrust::copy(handle_.on_stream(), first, last, dest);
+#else
+            static_assert(false, "Unregonized backend!");
+#endif
+        };
+
+        const auto give_slab = [&](const std::size_t k) {
+            const auto offset = bound(k);
+            on_slab(staging_slab<const typename MDG::value_type>{
+                .index  = k,
+                .offset = offset,
+                .data   = staging.subspan(offset, bound(k + 1uz) - offset) });
+        };
+
+#if defined(TYVI_BACKEND_CPU)
+        const auto copy_on_pool = [&](const std::size_t k) -> exec::unique_any_sender<> {
+            return exec::ensure_started(exec::schedule(exec::thread_pool_scheduler{})
+                                        | exec::then([&copy_slab, k] { copy_slab(k); }));
+        };
+
+        auto copying = copy_on_pool(0uz);
+        for (auto k = 0uz; k < slabs; ++k) {
+            this_thread::sync_wait(std::move(copying));
+
+            const auto has_next = k + 1uz < slabs;
+            if (has_next) { copying = copy_on_pool(k + 1uz); }
+
+            try {
+                give_slab(k);
+            } catch (...) {
+                // The copy in flight refers to this frame, so it has to finish before unwinding.
+                if (has_next) { this_thread::sync_wait(std::move(copying)); }
+                throw;
+            }
+        }
+#elif defined(TYVI_BACKEND_HIP)
+        // Events can be destroyed while they are recording, see when_all,
+        // so the slabs left in flight by a throwing on_slab do not need to be waited.
+        struct slab_events {
+            std::vector<hipEvent_t> events{};
+
+            slab_events()                              = default;
+            slab_events(const slab_events&)            = delete;
+            slab_events& operator=(const slab_events&) = delete;
+
+            ~slab_events() {
+                for (const auto e : events) { std::ignore = hipEventDestroy(e); }
+            }
+        };
+
+        auto arrived = slab_events{};
+        arrived.events.reserve(slabs);
+        for (auto k = 0uz; k < slabs; ++k) {
+            copy_slab(k);
+
+            auto e = hipEvent_t{};
+            detail::hip_check_error(hipEventCreateWithFlags(&e, hipEventDisableTiming));
+            arrived.events.push_back(e);
+            detail::hip_check_error(hipEventRecord(e, handle_.get()));
+        }
+
+        for (auto k = 0uz; k < slabs; ++k) {
+            detail::hip_check_error(hipEventSynchronize(arrived.events[k]));
+            give_slab(k);
+        }
+#else
+        static_assert(false, "Unregonized backend!");
+#endif
+
+        return *this;
+    }
+
     // NOLINTEND{modernize-use-nodiscard}
 
     void wait() const {
@@ -463,15 +702,35 @@ class mdgrid_work {
         return handle_.on_stream();
 #else
         static_assert(false, "Unregonized backend!");
+#endif
+    }
+
+    /// Same as on_this, but temporary storage of thrust algorithms is taken from alloc.
+    template<typename Alloc>
+    [[nodiscard]]
+    auto on_this(Alloc& alloc) const {
+#if defined(TYVI_BACKEND_CPU)
+        return thrust::device(alloc);
+#elif defined(TYVI_BACKEND_HIP)
+        return thrust::hip::par_nosync(alloc).on(handle_.get());
+#else
+        static_assert(false, "Unregonized backend!");
 #endif
     }
 };
 
 /// Insersts a synchronization point between the given mdgrid_works
+///
+/// Label is only used if tyvi is build with tyvi_ENABLE_INSTRUMENTATION.
 template<std::same_as<mdgrid_work>... T>
     requires(sizeof...(T) != 0)
 void
-when_all([[maybe_unused]] const T&... w) {
+when_all([[maybe_unused]] const std::string_view label, [[maybe_unused]] const T&... w) {
+    [[maybe_unused]]
+    const auto scope = std::get<0>(std::tie(w...)).trace_(label,
+                                                          instrumentation::operation::when_all,
+                                                          0uz);
+
 #if defined(TYVI_BACKEND_CPU)
     // MVP cpu backend in eager, so there is nothing to wait.
 #elif defined(TYVI_BACKEND_HIP)
@@ -504,6 +763,14 @@ when_all([[maybe_unused]] const T&... w) {
 #endif
 }
 
+/// Insersts a synchronization point between the given mdgrid_works
+template<std::same_as<mdgrid_work>... T>
+    requires(sizeof...(T) != 0)
+void
+when_all(const T&... w) {
+    when_all(std::string_view{}, w...);
+}
+
 } // namespace tyvi
 
 // NOLINTBEGIN
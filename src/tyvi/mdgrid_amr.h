@@ -0,0 +1,462 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <map>
+#include <set>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "thrust/copy.h"
+#include "thrust/device_vector.h"
+#include "thrust/for_each.h"
+#include "thrust/host_vector.h"
+#include "thrust/iterator/counting_iterator.h"
+
+#include "tyvi/execution.h"
+#include "tyvi/mdgrid.h"
+#include "tyvi/mdspan.h"
+#include "tyvi/sstd.h"
+
+namespace tyvi {
+
+/// Block-structured adaptive mesh refinement hierarchy of mdgrid blocks.
+///
+/// Every level is tiled by cubic blocks of block_size points per dimension,
+/// and only the blocks that exist are allocated, so memory scales with the refined volume.
+/// Level 0 is fully covered. Level l + 1 has Ratio times finer points than level l,
+/// and each of its blocks lies inside one block of level l, its parent.
+/// Blocks are identified by their coordinates on their level, i.e. offset / block_size.
+///
+/// Each block has its own mdgrid_work, so work issued to different blocks is independent.
+/// Operations over a level visit its blocks with for_each_block, which makes them run
+/// concurrently: with the hip backend on the streams of the blocks and with the eager
+/// cpu backend on the pika thread pool, so the pika runtime has to be running.
+template<auto ElemDesc, std::size_t Rank, std::size_t Ratio = 2>
+    requires(Rank >= 1 and Ratio >= 2)
+class [[nodiscard]] amr_mdgrid {
+  public:
+    using grid_extents_type = std::dextents<std::size_t, Rank>;
+    using grid_type         = mdgrid<ElemDesc, grid_extents_type>;
+    using value_type        = typename grid_type::value_type;
+    using coords_type       = std::array<std::size_t, Rank>;
+
+    static constexpr auto rank  = Rank;
+    static constexpr auto ratio = Ratio;
+
+    struct block {
+        grid_type grid;
+        coords_type coords;
+        /// Index of the first point of the block on its level.
+        coords_type offset;
+        mdgrid_work work;
+    };
+
+  private:
+    struct level_ {
+        std::vector<block> blocks{};
+        /// Index of block in blocks by its coordinates.
+        std::map<coords_type, std::size_t> index{};
+    };
+
+    coords_type base_blocks_;
+    std::size_t block_size_;
+    std::size_t max_levels_;
+    std::vector<level_> levels_;
+    std::string name_{};
+
+    /// Scratch of tag, block_points_() flags per block, reused between calls.
+    thrust::device_vector<std::uint8_t> tag_flags_{};
+    thrust::host_vector<std::uint8_t> tag_host_flags_{};
+
+    /// Number of points in a block.
+    [[nodiscard]]
+    auto block_points_() const -> std::size_t {
+        auto n = 1uz;
+        for (auto d = 0uz; d < Rank; ++d) { n *= block_size_; }
+        return n;
+    }
+
+    [[nodiscard]]
+    auto make_block_(const std::size_t l, const coords_type& coords) const -> block {
+        auto extents = std::array<std::size_t, Rank>{};
+        auto offset  = coords_type{};
+        for (auto d = 0uz; d < Rank; ++d) {
+            extents[d] = block_size_;
+            offset[d]  = coords[d] * block_size_;
+        }
+
+        auto b = block{ .grid   = grid_type(grid_extents_type(extents)),
+                        .coords = coords,
+                        .offset = offset,
+                        .work   = mdgrid_work{} };
+        if (not name_.empty()) { b.grid.set_name(std::format("{}[{}]{}", name_, l, coords)); }
+        return b;
+    }
+
+    /// Offset of index idx in mapping.
+    ///
+    /// Constexpr, so that it can be called in device code.
+    [[nodiscard]]
+    static constexpr auto linear_(const auto& mapping, const auto& idx) -> std::size_t {
+        return [&]<std::size_t... I>(std::index_sequence<I...>) {
+            return static_cast<std::size_t>(mapping(idx[I]...));
+        }(std::make_index_sequence<Rank>());
+    }
+
+    static void reindex_(level_& lvl) {
+        lvl.index.clear();
+        for (auto i = 0uz; i < lvl.blocks.size(); ++i) { lvl.index[lvl.blocks[i].coords] = i; }
+    }
+
+    /// Fills fine block from its parent by piecewise constant prolongation.
+    static void prolong_block_(block& fine, const block& parent) {
+        auto base = coords_type{};
+        for (auto d = 0uz; d < Rank; ++d) { base[d] = fine.offset[d] / Ratio - parent.offset[d]; }
+
+        parent.work.wait();
+        fine.work.for_each_index(
+            fine.grid,
+            [fine_mds = fine.grid.mds(), coarse_mds = parent.grid.mds(), base](const auto& idx,
+                                                                               const auto& jdx) {
+                auto cidx = coords_type{};
+                for (auto d = 0uz; d < Rank; ++d) { cidx[d] = base[d] + idx[d] / Ratio; }
+                fine_mds[idx][jdx] = coarse_mds[cidx][jdx];
+            });
+    }
+
+    /// Sets the points of parent covered by fine block to the averages of the fine points.
+    void average_down_block_(const block& fine, block& parent) const {
+        auto base = coords_type{};
+        for (auto d = 0uz; d < Rank; ++d) { base[d] = fine.offset[d] / Ratio - parent.offset[d]; }
+
+        // Fine block covers m^Rank coarse points.
+        const auto m = block_size_ / Ratio;
+        auto n       = 1uz;
+        for (auto d = 0uz; d < Rank; ++d) { n *= m; }
+
+        constexpr auto n_sub = [] {
+            auto k = 1uz;
+            for (auto d = 0uz; d < Rank; ++d) { k *= Ratio; }
+            return k;
+        }();
+
+        fine.work.wait();
+        parent.work.wait();
+        const auto kernel = [fine_mds = fine.grid.mds(), coarse_mds = parent.grid.mds(), base, m](
+                                const std::size_t linear) {
+            auto cidx = coords_type{};
+            auto fidx = coords_type{};
+            auto r    = linear;
+            for (auto d = Rank; d-- > 0uz;) {
+                cidx[d] = base[d] + r % m;
+                fidx[d] = (r % m) * Ratio;
+                r /= m;
+            }
+
+            const auto coarse_elem = coarse_mds[cidx];
+            for (const auto jdx : sstd::index_space(coarse_elem)) {
+                auto sum = value_type{};
+                for (auto s = 0uz; s < n_sub; ++s) {
+                    auto sub = fidx;
+                    auto q   = s;
+                    for (auto d = Rank; d-- > 0uz;) {
+                        sub[d] += q % Ratio;
+                        q /= Ratio;
+                    }
+                    sum += fine_mds[sub][jdx];
+                }
+                coarse_elem[jdx] = sum / static_cast<value_type>(n_sub);
+            }
+        };
+
+        const auto first = thrust::counting_iterator<std::size_t>(0uz);
+        const auto last  = first + static_cast<std::ptrdiff_t>(n);
+        thrust::for_each(fine.work.on_this(), first, last, kernel);
+    }
+
+    /// Removes blocks of levels above l whose parent does not exist anymore
+    /// and the empty levels at the top.
+    void prune_above_(const std::size_t l) {
+        for (auto k = l + 1uz; k < levels_.size(); ++k) {
+            auto& lvl = levels_[k];
+            std::erase_if(lvl.blocks, [&](const block& b) {
+                return find(k - 1uz, parent_coords(b.coords)) == nullptr;
+            });
+            reindex_(lvl);
+        }
+        while (levels_.size() > 1uz and levels_.back().blocks.empty()) { levels_.pop_back(); }
+    }
+
+  public:
+    /// Level 0 of base_blocks[d] blocks in each dimension and room for max_levels levels.
+    ///
+    /// Throws if block_size is not a positive multiple of Ratio or max_levels is zero.
+    explicit amr_mdgrid(const coords_type& base_blocks,
+                        const std::size_t block_size,
+                        const std::size_t max_levels)
+        : base_blocks_{ base_blocks },
+          block_size_{ block_size },
+          max_levels_{ max_levels } {
+        if (block_size == 0 or block_size % Ratio != 0) {
+            throw std::runtime_error{ std::format(
+                "AMR block size {} is not a positive multiple of refinement ratio {}!",
+                block_size,
+                Ratio) };
+        }
+        if (max_levels == 0) { throw std::runtime_error{ "AMR needs at least one level!" }; }
+
+        auto& base          = levels_.emplace_back();
+        const auto base_map = std::layout_right::mapping(grid_extents_type(base_blocks));
+        for (const auto idx : sstd::index_space(base_map)) {
+            auto coords = coords_type{};
+            for (auto d = 0uz; d < Rank; ++d) { coords[d] = idx[d]; }
+            base.blocks.push_back(make_block_(0, coords));
+        }
+        reindex_(base);
+    }
+
+    /// Name used for the blocks in tyvi::memory reports, as name[level][coords].
+    void set_name(std::string name) {
+        name_ = std::move(name);
+        for (auto l = 0uz; l < levels_.size(); ++l) {
+            for (auto& b : levels_[l].blocks) {
+                b.grid.set_name(std::format("{}[{}]{}", name_, l, b.coords));
+            }
+        }
+    }
+
+    [[nodiscard]]
+    auto block_size() const -> std::size_t {
+        return block_size_;
+    }
+
+    [[nodiscard]]
+    auto max_levels() const -> std::size_t {
+        return max_levels_;
+    }
+
+    /// Number of levels with at least one block.
+    [[nodiscard]]
+    auto num_levels() const -> std::size_t {
+        return levels_.size();
+    }
+
+    /// Number of points in each dimension of the domain on level l.
+    [[nodiscard]]
+    auto level_extents(const std::size_t l) const -> grid_extents_type {
+        auto scale = block_size_;
+        for (auto k = 0uz; k < l; ++k) { scale *= Ratio; }
+
+        auto e = std::array<std::size_t, Rank>{};
+        for (auto d = 0uz; d < Rank; ++d) { e[d] = base_blocks_[d] * scale; }
+        return grid_extents_type(e);
+    }
+
+    /// Blocks of level l, which is empty if l >= num_levels().
+    [[nodiscard]]
+    auto level(const std::size_t l) -> std::span<block> {
+        if (l >= levels_.size()) { return {}; }
+        return levels_[l].blocks;
+    }
+
+    [[nodiscard]]
+    auto level(const std::size_t l) const -> std::span<const block> {
+        if (l >= levels_.size()) { return {}; }
+        return levels_[l].blocks;
+    }
+
+    /// Block of level l with given coordinates or nullptr if it does not exist.
+    [[nodiscard]]
+    auto find(const std::size_t l, const coords_type& coords) -> block* {
+        if (l >= levels_.size()) { return nullptr; }
+        const auto it = levels_[l].index.find(coords);
+        return it == levels_[l].index.end() ? nullptr : &levels_[l].blocks[it->second];
+    }
+
+    [[nodiscard]]
+    auto find(const std::size_t l, const coords_type& coords) const -> const block* {
+        if (l >= levels_.size()) { return nullptr; }
+        const auto it = levels_[l].index.find(coords);
+        return it == levels_[l].index.end() ? nullptr : &levels_[l].blocks[it->second];
+    }
+
+    /// Coordinates of the parent of a block with given coordinates.
+    [[nodiscard]]
+    static auto parent_coords(coords_type coords) -> coords_type {
+        for (auto& c : coords) { c /= Ratio; }
+        return coords;
+    }
+
+    /// Calls f(block&) for each block of level l.
+    ///
+    /// With the hip backend f is called on the calling thread and the work it issues
+    /// is not waited, so the work of different blocks overlaps on their streams.
+    /// With the eager cpu backend f is called for each block in a task on the pika thread pool
+    /// and returns after all calls, so f has to be safe to call concurrently.
+    /// If any call throws, the exception is rethrown after all calls have finished.
+    template<typename F>
+    void for_each_block(const std::size_t l, F f) {
+#if defined(TYVI_BACKEND_CPU)
+        auto visits = std::vector<exec::unique_any_sender<>>{};
+        for (auto& b : level(l)) {
+            visits.push_back(exec::schedule(exec::thread_pool_scheduler{})
+                             | exec::then([&f, &b] { f(b); }));
+        }
+        this_thread::sync_wait(exec::when_all_vector(std::move(visits)));
+#elif defined(TYVI_BACKEND_HIP)
+        for (auto& b : level(l)) { f(b); }
+#else
+        static_assert(false, "Unregonized backend!");
+#endif
+    }
+
+    /// Same as mdgrid_work::for_each for each block of level l.
+    ///
+    /// Label is optional and only used if tyvi is build with tyvi_ENABLE_INSTRUMENTATION.
+    template<typename F>
+    void for_each(const std::size_t l, F f, const std::string_view label = {}) {
+        for_each_block(l, [&](block& b) { b.work.for_each(b.grid, f, label); });
+    }
+
+    /// Coordinates of the blocks of level l + 1 that cover the points of level l
+    /// for which pred(element mdspan) is true.
+    ///
+    /// pred is evaluated in parallel with the work of each block and the result is sorted.
+    template<typename Pred>
+    [[nodiscard]]
+    auto tag(const std::size_t l, Pred pred) -> std::vector<coords_type> {
+        const auto blocks = level(l);
+        const auto points = block_points_();
+        const auto n      = blocks.size() * points;
+        if (tag_flags_.size() < n) {
+            tag_flags_.resize(n);
+            tag_host_flags_.resize(n);
+        }
+
+        const auto all_flags = thrust::raw_pointer_cast(tag_flags_.data());
+        for_each_block(l, [&](block& b) {
+            const auto i   = static_cast<std::size_t>(&b - blocks.data());
+            const auto mds = b.grid.mds();
+            b.work.for_each_index(
+                mds, [mds, pred, flags = all_flags + i * points](const auto& idx) {
+                    const auto j = linear_(mds.mapping(), idx);
+                    flags[j]     = pred(mds[idx]) ? std::uint8_t{ 1 } : std::uint8_t{ 0 };
+                });
+        });
+        for (const auto& b : blocks) { b.work.wait(); }
+
+        thrust::copy(tag_flags_.begin(),
+                     tag_flags_.begin() + static_cast<std::ptrdiff_t>(n),
+                     tag_host_flags_.begin());
+
+        auto tagged = std::set<coords_type>{};
+        for (auto i = 0uz; i < blocks.size(); ++i) {
+            const auto& b  = blocks[i];
+            const auto mds = b.grid.mds();
+            for (const auto idx : sstd::index_space(mds)) {
+                if (tag_host_flags_[i * points + linear_(mds.mapping(), idx)] == 0) { continue; }
+                auto child = coords_type{};
+                for (auto d = 0uz; d < Rank; ++d) {
+                    child[d] = (b.offset[d] + idx[d]) * Ratio / block_size_;
+                }
+                tagged.insert(child);
+            }
+        }
+        return { tagged.begin(), tagged.end() };
+    }
+
+    /// Makes level l + 1 consist of the blocks given by tag(l, pred).
+    ///
+    /// Blocks that already exist are kept with their data, new blocks are prolonged
+    /// from level l and blocks that are not tagged anymore are removed.
+    /// Blocks of finer levels without a parent are removed as well.
+    /// Waits for the work of all blocks of level l + 1.
+    ///
+    /// Throws if l + 1 is not below max_levels().
+    template<typename Pred>
+    void regrid(const std::size_t l, Pred pred) {
+        if (l + 1uz >= max_levels_) {
+            throw std::runtime_error{ std::format(
+                "Can not refine level {} of AMR with {} levels!", l, max_levels_) };
+        }
+        if (l >= levels_.size()) { return; }
+
+        const auto tagged = tag(l, pred);
+        if (levels_.size() == l + 1uz) { levels_.emplace_back(); }
+
+        auto& fine      = levels_[l + 1uz];
+        auto old_blocks = std::move(fine.blocks);
+        auto old_index  = std::move(fine.index);
+
+        fine.blocks.clear();
+        fine.blocks.reserve(tagged.size());
+        auto is_new = std::vector<bool>{};
+        for (const auto& coords : tagged) {
+            if (const auto it = old_index.find(coords); it != old_index.end()) {
+                fine.blocks.push_back(std::move(old_blocks[it->second]));
+                is_new.push_back(false);
+            } else {
+                fine.blocks.push_back(make_block_(l + 1uz, coords));
+                is_new.push_back(true);
+            }
+        }
+        reindex_(fine);
+
+        for_each_block(l + 1uz, [&](block& b) {
+            const auto i = static_cast<std::size_t>(&b - fine.blocks.data());
+            if (is_new[i]) { prolong_block_(b, *find(l, parent_coords(b.coords))); }
+        });
+        for (const auto& b : fine.blocks) { b.work.wait(); }
+
+        prune_above_(l + 1uz);
+    }
+
+    /// Fills all blocks of level l + 1 from level l by piecewise constant prolongation.
+    ///
+    /// Prolongation is conservative: average_down(l) after prolong(l) gives level l back.
+    /// Issued to the work of the fine blocks after waiting for the work of their parents.
+    void prolong(const std::size_t l) {
+        for_each_block(l + 1uz,
+                       [&](block& b) { prolong_block_(b, *find(l, parent_coords(b.coords))); });
+    }
+
+    /// Sets the points of level l covered by level l + 1 to averages of the fine points.
+    ///
+    /// Waits for the earlier work of the fine blocks and their parents,
+    /// issues the averaging to the work of the fine blocks and waits for it.
+    void average_down(const std::size_t l) {
+        // Fine blocks sharing a parent write disjoint points of it.
+        for_each_block(l + 1uz, [&](block& b) {
+            average_down_block_(b, *find(l, parent_coords(b.coords)));
+        });
+        for (const auto& b : level(l + 1uz)) { b.work.wait(); }
+    }
+
+    void sync_to_staging(const std::string_view label = {}) {
+        for (auto l = 0uz; l < levels_.size(); ++l) {
+            for_each_block(l, [&](block& b) { b.work.sync_to_staging(b.grid, label); });
+        }
+    }
+
+    void sync_from_staging(const std::string_view label = {}) {
+        for (auto l = 0uz; l < levels_.size(); ++l) {
+            for_each_block(l, [&](block& b) { b.work.sync_from_staging(b.grid, label); });
+        }
+    }
+
+    /// Waits for the work issued to all blocks.
+    void wait() const {
+        for (const auto& lvl : levels_) {
+            for (const auto& b : lvl.blocks) { b.work.wait(); }
+        }
+    }
+};
+
+} // namespace tyvi
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "tyvi/mdgrid.h"
+#include "tyvi/mdspan.h"
+#include "tyvi/numa.h"
+
+namespace tyvi {
+
+/// Grid decomposed into blocks, each placed on one NUMA node.
+///
+/// Global extents are split along the first (slowest varying) dimension.
+/// Each block is an mdgrid with its own mdgrid_work,
+/// which is allocated and first touched by a thread pinned to the node of the block.
+/// Operations over the whole grid are dispatched to the blocks on threads pinned the same way,
+/// so each block is only streamed through the memory of its own node.
+/// The threads are persistent, see numa::run_pinned.
+template<auto ElemDesc, typename GridExtents>
+    requires(GridExtents::rank() >= 1 and GridExtents::static_extent(0) == std::dynamic_extent)
+class [[nodiscard]] blocked_mdgrid {
+  public:
+    using grid_type         = mdgrid<ElemDesc, GridExtents>;
+    using grid_extents_type = GridExtents;
+    using index_type        = typename GridExtents::index_type;
+
+    static constexpr auto rank = GridExtents::rank();
+
+    struct block {
+        grid_type grid;
+        /// Index of the first element of the block in the global grid.
+        std::array<index_type, rank> offset;
+        mdgrid_work work;
+        numa::node const* node;
+    };
+
+  private:
+    grid_extents_type extents_;
+    std::vector<block> blocks_;
+
+    [[nodiscard]]
+    auto nodes_of_blocks_() const -> std::vector<numa::node const*> {
+        auto n = std::vector<numa::node const*>{};
+        n.reserve(blocks_.size());
+        for (const auto& b : blocks_) { n.push_back(b.node); }
+        return n;
+    }
+
+  public:
+    /// Splits extents into num_blocks blocks of nearly equal size.
+    ///
+    /// Consecutive blocks are assigned to the same node, so that the blocks are spread evenly.
+    /// Number of blocks is clamped to the first extent.
+    explicit blocked_mdgrid(const grid_extents_type& extents,
+                            const std::size_t num_blocks = numa::nodes().size())
+        : extents_{ extents } {
+        const auto& nodes = numa::nodes();
+        const auto n0     = static_cast<std::size_t>(extents.extent(0));
+        const auto n      = std::clamp(num_blocks, 1uz, std::max(n0, 1uz));
+
+        auto node_of_block = std::vector<numa::node const*>(n);
+        for (auto i = 0uz; i < n; ++i) { node_of_block[i] = &nodes[i * nodes.size() / n]; }
+
+        auto slots = std::vector<std::optional<block>>(n);
+        numa::run_pinned(node_of_block, [&](const std::size_t i) {
+            const auto begin = i * n0 / n;
+            const auto end   = (i + 1uz) * n0 / n;
+
+            auto block_extents = std::array<index_type, rank>{};
+            for (auto d = 0uz; d < rank; ++d) { block_extents[d] = extents.extent(d); }
+            block_extents[0] = static_cast<index_type>(end - begin);
+
+            auto offset = std::array<index_type, rank>{};
+            offset[0]   = static_cast<index_type>(begin);
+
+            slots[i].emplace(grid_type(grid_extents_type(block_extents)),
+                             offset,
+                             mdgrid_work{},
+                             node_of_block[i]);
+        });
+
+        blocks_.reserve(n);
+        for (auto& s : slots) { blocks_.push_back(std::move(*s)); }
+    }
+
+    template<typename... Indices>
+        requires std::constructible_from<grid_extents_type, Indices...>
+    explicit blocked_mdgrid(const Indices... extents)
+        : blocked_mdgrid(grid_extents_type(extents...)) {}
+
+    [[nodiscard]]
+    auto extents() const -> grid_extents_type {
+        return extents_;
+    }
+
+    [[nodiscard]]
+    auto blocks() -> std::span<block> {
+        return blocks_;
+    }
+
+    [[nodiscard]]
+    auto blocks() const -> std::span<const block> {
+        return blocks_;
+    }
+
+    /// Calls f(block&) for each block concurrently on threads pinned to the node of the block.
+    ///
+    /// Waits until the calls have returned, but not for the work they issued.
+    template<typename F>
+    void for_each_block(F f) {
+        numa::run_pinned(nodes_of_blocks_(), [&](const std::size_t i) { f(blocks_[i]); });
+    }
+
+    /// Same as mdgrid_work::for_each for each block, i.e. f is given the element mdspan.
+    ///
+    /// Label is optional and only used if tyvi is build with tyvi_ENABLE_INSTRUMENTATION.
+    template<typename F>
+    void for_each(F f, const std::string_view label = {}) {
+        for_each_block([&](block& b) { b.work.for_each(b.grid, f, label); });
+    }
+
+    void sync_to_staging(const std::string_view label = {}) {
+        for_each_block([&](block& b) { b.work.sync_to_staging(b.grid, label); });
+    }
+
+    void sync_from_staging(const std::string_view label = {}) {
+        for_each_block([&](block& b) { b.work.sync_from_staging(b.grid, label); });
+    }
+
+    /// Waits for the work issued to all blocks.
+    void wait() const {
+        for (const auto& b : blocks_) { b.work.wait(); }
+    }
+};
+
+} // namespace tyvi
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <format>
+#include <span>
+#include <string>
+#include <utility>
+
+#include "tyvi/mdgrid.h"
+#include "tyvi/mdspan.h"
+
+namespace tyvi {
+
+/// N same-shaped mdgrids whose roles rotate, e.g. time levels of an explicit integrator.
+///
+/// current() is the newest grid and previous(k) the grid k steps older.
+/// advance() makes the oldest grid current in O(1) without copying or allocating,
+/// so pointers and [md]spans to the grids stay valid and only change roles.
+/// Grids are ordinary mdgrids, so they are used with mdgrid_work and staging buffers as is.
+template<auto ElemDesc,
+         typename GridExtents,
+         std::size_t N,
+         typename GridLayoutPolicy = std::layout_right>
+    requires(N >= 2)
+class [[nodiscard]] mdgrid_ring {
+  public:
+    using grid_type         = mdgrid<ElemDesc, GridExtents, GridLayoutPolicy>;
+    using grid_extents_type = GridExtents;
+
+    static constexpr auto num_grids = N;
+
+  private:
+    std::array<grid_type, N> grids_;
+    /// Index of current() in grids_.
+    std::size_t current_{ 0 };
+
+    template<std::size_t... I>
+    [[nodiscard]]
+    static auto make_grids_(const grid_extents_type& extents, std::index_sequence<I...>)
+        -> std::array<grid_type, N> {
+        return { ((void)I, grid_type(extents))... };
+    }
+
+  public:
+    explicit mdgrid_ring(const grid_extents_type& extents)
+        : grids_(make_grids_(extents, std::make_index_sequence<N>{})) {}
+
+    template<typename... Indices>
+        requires std::constructible_from<grid_extents_type, Indices...>
+    explicit mdgrid_ring(const Indices... extents) : mdgrid_ring(grid_extents_type(extents...)) {}
+
+    [[nodiscard]]
+    auto current() -> grid_type& {
+        return grids_[current_];
+    }
+
+    [[nodiscard]]
+    auto current() const -> const grid_type& {
+        return grids_[current_];
+    }
+
+    /// Grid k steps older than current(), k in [0, N).
+    [[nodiscard]]
+    auto previous(const std::size_t k = 1) -> grid_type& {
+        return grids_[(current_ + N - (k % N)) % N];
+    }
+
+    [[nodiscard]]
+    auto previous(const std::size_t k = 1) const -> const grid_type& {
+        return grids_[(current_ + N - (k % N)) % N];
+    }
+
+    /// Makes the oldest grid current, so the old current() becomes previous().
+    ///
+    /// Contents of the new current() are whatever the oldest grid held.
+    /// Work issued to the grids has to be ordered by the caller as for any mdgrid,
+    /// e.g. by issuing the next step with the same mdgrid_work.
+    void advance() { current_ = (current_ + 1uz) % N; }
+
+    /// All grids in storage order, which does not change in advance().
+    [[nodiscard]]
+    auto grids() -> std::span<grid_type, N> {
+        return grids_;
+    }
+
+    [[nodiscard]]
+    auto grids() const -> std::span<const grid_type, N> {
+        return grids_;
+    }
+
+    [[nodiscard]]
+    auto extents() const -> grid_extents_type {
+        return grids_.front().extents();
+    }
+
+    /// Names grids as name[i] in tyvi::memory reports, where i is the storage index.
+    void set_name(const std::string& name) {
+        for (auto i = 0uz; i < N; ++i) { grids_[i].set_name(std::format("{}[{}]", name, i)); }
+    }
+
+    void invalidating_resize(const grid_extents_type& extents) {
+        for (auto& g : grids_) { g.invalidating_resize(extents); }
+    }
+};
+
+/// Two grids swapping roles, e.g. u_old and u_new.
+template<auto ElemDesc, typename GridExtents, typename GridLayoutPolicy = std::layout_right>
+using double_mdgrid = mdgrid_ring<ElemDesc, GridExtents, 2, GridLayoutPolicy>;
+
+} // namespace tyvi
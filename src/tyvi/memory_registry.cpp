@@ -0,0 +1,254 @@
+#include "tyvi/memory_registry.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <functional>
+#include <mutex>
+#include <ranges>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "tyvi/sstd.h"
+
+namespace {
+
+namespace tmem = tyvi::memory;
+
+/// Totals are atomics so that they can be read without locking.
+/// Table of live allocations is only touched when grids are created, resized or destroyed.
+class memory_registry : tyvi::sstd::immovable {
+    std::atomic<std::size_t> device_{ 0 };
+    std::atomic<std::size_t> staging_{ 0 };
+    std::atomic<std::size_t> peak_device_{ 0 };
+    std::atomic<std::size_t> peak_staging_{ 0 };
+
+    std::atomic<std::uint64_t> next_id_{ 1 };
+
+    std::mutex mutex_;
+    std::unordered_map<std::uint64_t, tmem::allocation> live_;
+
+    static void raise_peak_(std::atomic<std::size_t>& peak, const std::size_t value) {
+        auto p = peak.load(std::memory_order_relaxed);
+        while (p < value and not peak.compare_exchange_weak(p, value, std::memory_order_relaxed)) {}
+    }
+
+    void add_(const tmem::usage bytes) {
+        const auto d = device_.fetch_add(bytes.device_bytes, std::memory_order_relaxed);
+        const auto s = staging_.fetch_add(bytes.staging_bytes, std::memory_order_relaxed);
+        raise_peak_(peak_device_, d + bytes.device_bytes);
+        raise_peak_(peak_staging_, s + bytes.staging_bytes);
+    }
+
+    void sub_(const tmem::usage bytes) {
+        device_.fetch_sub(bytes.device_bytes, std::memory_order_relaxed);
+        staging_.fetch_sub(bytes.staging_bytes, std::memory_order_relaxed);
+    }
+
+  public:
+    [[nodiscard]]
+    auto add(const tmem::usage bytes, std::string name) -> std::uint64_t {
+        const auto id = next_id_.fetch_add(1, std::memory_order_relaxed);
+        {
+            [[maybe_unused]]
+            const std::scoped_lock _{ mutex_ };
+            live_.emplace(id, tmem::allocation{ .name = std::move(name), .bytes = bytes });
+        }
+        add_(bytes);
+        return id;
+    }
+
+    void update(const std::uint64_t id, const tmem::usage bytes) {
+        auto old = tmem::usage{};
+        {
+            [[maybe_unused]]
+            const std::scoped_lock _{ mutex_ };
+            auto& a = live_.at(id);
+            old     = std::exchange(a.bytes, bytes);
+        }
+        sub_(old);
+        add_(bytes);
+    }
+
+    void remove(const std::uint64_t id) {
+        auto old = tmem::usage{};
+        {
+            [[maybe_unused]]
+            const std::scoped_lock _{ mutex_ };
+            const auto it = live_.find(id);
+            if (it == live_.end()) { return; }
+            old = it->second.bytes;
+            live_.erase(it);
+        }
+        sub_(old);
+    }
+
+    [[nodiscard]]
+    auto get(const std::uint64_t id) -> tmem::allocation {
+        [[maybe_unused]]
+        const std::scoped_lock _{ mutex_ };
+        return live_.at(id);
+    }
+
+    void set_name(const std::uint64_t id, std::string name) {
+        [[maybe_unused]]
+        const std::scoped_lock _{ mutex_ };
+        live_.at(id).name = std::move(name);
+    }
+
+    [[nodiscard]]
+    auto current() const -> tmem::usage {
+        return { .device_bytes  = device_.load(std::memory_order_relaxed),
+                 .staging_bytes = staging_.load(std::memory_order_relaxed) };
+    }
+
+    [[nodiscard]]
+    auto peak() const -> tmem::usage {
+        return { .device_bytes  = peak_device_.load(std::memory_order_relaxed),
+                 .staging_bytes = peak_staging_.load(std::memory_order_relaxed) };
+    }
+
+    void reset_peak() {
+        peak_device_.store(device_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        peak_staging_.store(staging_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+    [[nodiscard]]
+    auto allocations() -> std::vector<tmem::allocation> {
+        auto result = [&] {
+            [[maybe_unused]]
+            const std::scoped_lock _{ mutex_ };
+            return live_ | std::views::values | std::ranges::to<std::vector>();
+        }();
+
+        std::ranges::sort(result, std::ranges::greater{}, [](const tmem::allocation& a) {
+            return a.bytes.total();
+        });
+        return result;
+    }
+};
+
+[[nodiscard]]
+memory_registry&
+registry() {
+    static memory_registry r{};
+    return r;
+}
+
+} // namespace
+
+namespace tyvi::memory {
+
+auto
+current() -> usage {
+    return registry().current();
+}
+
+auto
+peak() -> usage {
+    return registry().peak();
+}
+
+void
+reset_peak() {
+    registry().reset_peak();
+}
+
+auto
+allocations() -> std::vector<allocation> {
+    return registry().allocations();
+}
+
+void
+write_report(std::ostream& os) {
+    static constexpr auto MiB = 1024.0 * 1024.0;
+
+    const auto as_mib = [](const std::size_t bytes) { return static_cast<double>(bytes) / MiB; };
+
+    const auto c = current();
+    const auto p = peak();
+
+    os << std::format("{:<32} {:>14} {:>14} {:>14}\n",
+                      "",
+                      "device [MiB]",
+                      "staging [MiB]",
+                      "total [MiB]");
+    os << std::format("{:<32} {:>14.2f} {:>14.2f} {:>14.2f}\n",
+                      "current",
+                      as_mib(c.device_bytes),
+                      as_mib(c.staging_bytes),
+                      as_mib(c.total()));
+    os << std::format("{:<32} {:>14.2f} {:>14.2f} {:>14.2f}\n",
+                      "peak",
+                      as_mib(p.device_bytes),
+                      as_mib(p.staging_bytes),
+                      as_mib(p.total()));
+
+    for (const auto& a : allocations()) {
+        os << std::format("{:<32} {:>14.2f} {:>14.2f} {:>14.2f}\n",
+                          a.name.empty() ? "<unnamed>" : a.name,
+                          as_mib(a.bytes.device_bytes),
+                          as_mib(a.bytes.staging_bytes),
+                          as_mib(a.bytes.total()));
+    }
+}
+
+} // namespace tyvi::memory
+
+namespace tyvi::detail {
+
+memory_registration::memory_registration(const memory::usage bytes)
+    : id_{ registry().add(bytes, {}) } {}
+
+memory_registration::memory_registration(const memory_registration& other) {
+    if (other.id_ != 0) {
+        auto a = registry().get(other.id_);
+        id_    = registry().add(a.bytes, std::move(a.name));
+    }
+}
+
+memory_registration::memory_registration(memory_registration&& other) noexcept
+    : id_{ std::exchange(other.id_, 0) } {}
+
+memory_registration&
+memory_registration::operator=(const memory_registration& other) {
+    auto tmp     = other; // Makes sure self assignment is benign.
+    return *this = std::move(tmp);
+}
+
+memory_registration&
+memory_registration::operator=(memory_registration&& other) noexcept {
+    std::swap(id_, other.id_);
+    return *this;
+}
+
+memory_registration::~memory_registration() {
+    if (id_ != 0) { registry().remove(id_); }
+}
+
+void
+memory_registration::update(const memory::usage bytes) {
+    if (id_ == 0) {
+        id_ = registry().add(bytes, {});
+    } else {
+        registry().update(id_, bytes);
+    }
+}
+
+void
+memory_registration::set_name(std::string name) {
+    if (id_ == 0) { id_ = registry().add({}, {}); }
+    registry().set_name(id_, std::move(name));
+}
+
+auto
+memory_registration::name() const -> std::string {
+    if (id_ == 0) { return {}; }
+    return registry().get(id_).name;
+}
+
+} // namespace tyvi::detail
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace tyvi::memory {
+
+/// Bytes held in device and staging buffers.
+struct usage {
+    std::size_t device_bytes{};
+    std::size_t staging_bytes{};
+
+    [[nodiscard]]
+    constexpr auto total() const -> std::size_t {
+        return device_bytes + staging_bytes;
+    }
+};
+
+/// Live allocation of a single grid.
+struct allocation {
+    /// Empty if the grid has not been named.
+    std::string name;
+    usage bytes;
+};
+
+/// Bytes currently held by all live grids.
+[[nodiscard]]
+auto current() -> usage;
+
+/// Highest usage since the start of the program or the last reset_peak.
+///
+/// Peaks of device and staging buffers are tracked separately,
+/// so they might not have been reached at the same time.
+[[nodiscard]]
+auto peak() -> usage;
+
+/// Set peak usage to the current usage.
+void reset_peak();
+
+/// All live allocations, largest first.
+[[nodiscard]]
+auto allocations() -> std::vector<allocation>;
+
+/// Write human readable table of the current, peak and live allocations.
+void write_report(std::ostream& os);
+
+} // namespace tyvi::memory
+
+namespace tyvi::detail {
+
+/// Registers bytes held by its owner to the global memory registry for its lifetime.
+///
+/// Copies register the same amount of bytes with the same name.
+class memory_registration {
+    /// Zero means that nothing is registered (moved-from state).
+    std::uint64_t id_{ 0 };
+
+  public:
+    memory_registration() = default;
+    explicit memory_registration(memory::usage bytes);
+
+    memory_registration(const memory_registration&);
+    memory_registration(memory_registration&&) noexcept;
+    memory_registration& operator=(const memory_registration&);
+    memory_registration& operator=(memory_registration&&) noexcept;
+
+    ~memory_registration();
+
+    /// Change the amount of registered bytes, e.g. after resize.
+    void update(memory::usage bytes);
+
+    void set_name(std::string name);
+
+    [[nodiscard]]
+    auto name() const -> std::string;
+};
+
+} // namespace tyvi::detail
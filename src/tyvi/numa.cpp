@@ -0,0 +1,235 @@
+#include "tyvi/numa.h"
+
+#include <algorithm>
+#include <charconv>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <latch>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ranges>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#    include <pthread.h>
+#    include <sched.h>
+#endif
+
+namespace {
+
+namespace tnu = tyvi::numa;
+
+[[nodiscard]]
+auto
+parse_index(const std::string_view str) -> std::optional<std::size_t> {
+    auto x             = 0uz;
+    const auto [p, ec] = std::from_chars(str.data(), str.data() + str.size(), x);
+    if (ec != std::errc{} or p != str.data() + str.size()) { return {}; }
+    return x;
+}
+
+/// Cpus the process is allowed to run on.
+[[nodiscard]]
+auto
+allowed_cpus() -> std::vector<std::size_t> {
+    auto cpus = std::vector<std::size_t>{};
+#if defined(__linux__)
+    auto set = cpu_set_t{};
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (auto cpu = 0uz; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) { cpus.push_back(cpu); }
+        }
+    }
+#endif
+    if (cpus.empty()) {
+        const auto n = std::max(std::thread::hardware_concurrency(), 1u);
+        for (auto cpu = 0uz; cpu < n; ++cpu) { cpus.push_back(cpu); }
+    }
+    return cpus;
+}
+
+[[nodiscard]]
+auto
+read_nodes() -> std::vector<tnu::node> {
+    const auto allowed = allowed_cpus();
+    auto nodes         = std::vector<tnu::node>{};
+
+    const auto root = std::filesystem::path("/sys/devices/system/node");
+    auto ec         = std::error_code{};
+    for (const auto& entry : std::filesystem::directory_iterator(root, ec)) {
+        const auto name = entry.path().filename().string();
+        if (not name.starts_with("node")) { continue; }
+
+        const auto id = parse_index(std::string_view(name).substr(4));
+        if (not id) { continue; }
+
+        auto file = std::ifstream(entry.path() / "cpulist");
+        auto str  = std::string(std::istreambuf_iterator<char>(file), {});
+
+        auto cpus = std::vector<std::size_t>{};
+        const auto is_allowed = [&](const auto cpu) {
+            return std::ranges::binary_search(allowed, cpu);
+        };
+        std::ranges::copy_if(tnu::parse_cpulist(str), std::back_inserter(cpus), is_allowed);
+
+        if (not cpus.empty()) { nodes.push_back({ .id = *id, .cpus = std::move(cpus) }); }
+    }
+
+    if (nodes.empty()) { nodes.push_back({ .id = 0, .cpus = allowed }); }
+    std::ranges::sort(nodes, {}, &tnu::node::id);
+    return nodes;
+}
+
+/// Thread pinned to the cpus of a node, which runs one task at a time.
+class pinned_worker {
+    std::mutex mutex_;
+    std::condition_variable_any cv_;
+    std::function<void()> task_{};
+    std::jthread thread_;
+
+  public:
+    explicit pinned_worker(const tnu::node& n)
+        : thread_{ [this, n](const std::stop_token stop) {
+              tnu::pin_this_thread(n);
+              auto lock = std::unique_lock{ mutex_ };
+              while (cv_.wait(lock, stop, [&] { return static_cast<bool>(task_); })) {
+                  auto task = std::exchange(task_, {});
+                  lock.unlock();
+                  task();
+                  lock.lock();
+              }
+          } } {}
+
+    pinned_worker(const pinned_worker&)            = delete;
+    pinned_worker& operator=(const pinned_worker&) = delete;
+
+    /// Assumes that the previous task has been started.
+    void post(std::function<void()> task) {
+        {
+            const auto _ = std::scoped_lock{ mutex_ };
+            task_        = std::move(task);
+        }
+        cv_.notify_one();
+    }
+};
+
+/// Workers of run_pinned by the cpus they are pinned to.
+class pinned_pool {
+    std::mutex mutex_;
+    std::map<std::vector<std::size_t>, std::vector<std::unique_ptr<pinned_worker>>> workers_;
+
+  public:
+    [[nodiscard]]
+    static auto instance() -> pinned_pool& {
+        static auto pool = pinned_pool{};
+        return pool;
+    }
+
+    void run(const std::span<tnu::node const* const> nodes_of_tasks,
+             const std::function<void(std::size_t)>& f) {
+        const auto _ = std::scoped_lock{ mutex_ };
+
+        auto errors = std::vector<std::exception_ptr>(nodes_of_tasks.size());
+        auto done   = std::latch(static_cast<std::ptrdiff_t>(nodes_of_tasks.size()));
+
+        // Number of tasks of this call given to workers of each cpu set.
+        auto used = std::map<std::vector<std::size_t>, std::size_t>{};
+        for (auto i = 0uz; i < nodes_of_tasks.size(); ++i) {
+            const auto& n = *nodes_of_tasks[i];
+            auto& ws      = workers_[n.cpus];
+            auto& k       = used[n.cpus];
+            if (k == ws.size()) { ws.push_back(std::make_unique<pinned_worker>(n)); }
+
+            ws[k++]->post([&, i] {
+                try {
+                    std::invoke(f, i);
+                } catch (...) { errors[i] = std::current_exception(); }
+                done.count_down();
+            });
+        }
+        done.wait();
+
+        for (const auto& e : errors) {
+            if (e) { std::rethrow_exception(e); }
+        }
+    }
+};
+
+} // namespace
+
+auto
+tyvi::numa::parse_cpulist(std::string_view str) -> std::vector<std::size_t> {
+    while (not str.empty() and (str.back() == '\n' or str.back() == ' ')) {
+        str.remove_suffix(1);
+    }
+    if (str.empty()) { return {}; }
+
+    auto cpus = std::vector<std::size_t>{};
+    for (const auto part : str | std::views::split(',')) {
+        const auto range = std::string_view(part);
+        const auto dash  = range.find('-');
+
+        const auto first = parse_index(range.substr(0, dash));
+        const auto last =
+            dash == std::string_view::npos ? first : parse_index(range.substr(dash + 1));
+        if (not first or not last or *last < *first) { return {}; }
+
+        for (auto cpu = *first; cpu <= *last; ++cpu) { cpus.push_back(cpu); }
+    }
+    return cpus;
+}
+
+auto
+tyvi::numa::format_cpulist(const std::span<const std::size_t> cpus) -> std::string {
+    auto str = std::string{};
+    for (auto i = 0uz; i < cpus.size();) {
+        auto j = i + 1uz;
+        while (j < cpus.size() and cpus[j] == cpus[j - 1uz] + 1uz) { ++j; }
+
+        if (not str.empty()) { str += ','; }
+        str += std::to_string(cpus[i]);
+        if (j - i > 1uz) { str += '-' + std::to_string(cpus[j - 1uz]); }
+        i = j;
+    }
+    return str;
+}
+
+auto
+tyvi::numa::nodes() -> const std::vector<node>& {
+    static const auto n = read_nodes();
+    return n;
+}
+
+auto
+tyvi::numa::pin_this_thread([[maybe_unused]] const node& n) -> bool {
+#if defined(__linux__)
+    auto set = cpu_set_t{};
+    CPU_ZERO(&set);
+    for (const auto cpu : n.cpus) {
+        if (cpu < CPU_SETSIZE) { CPU_SET(cpu, &set); }
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+void
+tyvi::numa::run_pinned(const std::span<node const* const> nodes_of_tasks,
+                       const std::function<void(std::size_t)>& f) {
+    pinned_pool::instance().run(nodes_of_tasks, f);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace tyvi::numa {
+
+/// NUMA node and the cpus local to it, which the process is allowed to run on.
+struct node {
+    std::size_t id;
+    std::vector<std::size_t> cpus;
+};
+
+/// NUMA nodes of the machine, which have cpus the process is allowed to run on.
+///
+/// Topology is read once from /sys/devices/system/node on Linux.
+/// If it is not available, there is one node with all the cpus.
+[[nodiscard]]
+auto nodes() -> const std::vector<node>&;
+
+/// Parses Linux cpu list format, e.g. "0-3,8,10-11".
+///
+/// Returns empty vector if str is malformed.
+[[nodiscard]]
+auto parse_cpulist(std::string_view str) -> std::vector<std::size_t>;
+
+/// Formats cpus in Linux cpu list format, merging consecutive cpus to ranges.
+[[nodiscard]]
+auto format_cpulist(std::span<const std::size_t> cpus) -> std::string;
+
+/// Restricts the calling thread to the cpus of given node.
+///
+/// Threads created afterwards by the calling thread, e.g. OpenMP workers, inherit the restriction.
+/// Returns false if pinning is not supported or it failed.
+auto pin_this_thread(const node& n) -> bool;
+
+/// Calls f(i) for each i in [0, nodes_of_tasks.size()) concurrently,
+/// each on its own thread pinned to nodes_of_tasks[i], and waits for them.
+///
+/// Memory first touched by f(i) is therefore placed on nodes_of_tasks[i].
+/// If any call throws, one of the exceptions is rethrown after all calls have finished.
+///
+/// Threads are taken from a pool of the process, which is grown on demand and kept
+/// until exit, so threads are not created nor pinned again on every call.
+/// Calls of run_pinned are serialized, so f must not call run_pinned.
+///
+/// Threads are pinned to the cpus of the whole node, independent of tyvi::affinity::config
+/// (TYVI_BIND, TYVI_NUM_THREADS), which only applies to the pika worker threads.
+void run_pinned(std::span<node const* const> nodes_of_tasks,
+                const std::function<void(std::size_t)>& f);
+
+} // namespace tyvi::numa
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <map>
+#include <tuple>
+#include <utility>
+
+#include "thrust/binary_search.h"
+#include "thrust/device_free.h"
+#include "thrust/device_malloc.h"
+#include "thrust/device_vector.h"
+#include "thrust/host_vector.h"
+#include "thrust/iterator/counting_iterator.h"
+#include "thrust/sequence.h"
+#include "thrust/sort.h"
+
+#include "tyvi/mdgrid.h"
+#include "tyvi/mdspan.h"
+#include "tyvi/particles.h"
+
+namespace tyvi {
+
+namespace detail {
+
+/// Allocator of temporary storage for thrust algorithms, which keeps freed blocks for reuse.
+///
+/// A free block is reused for any request not larger than it,
+/// so repeating algorithms with the same input sizes does not allocate.
+/// Blocks are released when the allocator is destroyed.
+class [[nodiscard]] caching_temporary_allocator {
+    std::multimap<std::ptrdiff_t, char*> free_{};
+    std::map<char*, std::ptrdiff_t> in_use_{};
+
+  public:
+    using value_type = char;
+
+    caching_temporary_allocator() = default;
+
+    caching_temporary_allocator(const caching_temporary_allocator&)            = delete;
+    caching_temporary_allocator& operator=(const caching_temporary_allocator&) = delete;
+
+    caching_temporary_allocator(caching_temporary_allocator&& other) noexcept
+        : free_(std::exchange(other.free_, {})),
+          in_use_(std::exchange(other.in_use_, {})) {}
+
+    /// Blocks of this are released by other.
+    caching_temporary_allocator& operator=(caching_temporary_allocator&& other) noexcept {
+        std::swap(free_, other.free_);
+        std::swap(in_use_, other.in_use_);
+        return *this;
+    }
+
+    ~caching_temporary_allocator() {
+        for (const auto& [_, ptr] : free_) {
+            thrust::device_free(thrust::device_pointer_cast(ptr));
+        }
+        for (const auto& [ptr, _] : in_use_) {
+            thrust::device_free(thrust::device_pointer_cast(ptr));
+        }
+    }
+
+    [[nodiscard]]
+    auto allocate(const std::ptrdiff_t n) -> char* {
+        if (const auto it = free_.lower_bound(n); it != free_.end()) {
+            const auto [size, ptr] = *it;
+            free_.erase(it);
+            in_use_.emplace(ptr, size);
+            return ptr;
+        }
+
+        auto* const ptr = thrust::raw_pointer_cast(thrust::device_malloc<char>(n));
+        in_use_.emplace(ptr, n);
+        return ptr;
+    }
+
+    void deallocate(char* const ptr, std::size_t) {
+        const auto it = in_use_.find(ptr);
+        free_.emplace(it->second, ptr);
+        in_use_.erase(it);
+    }
+
+    /// Bytes of all blocks held, both free and in use.
+    [[nodiscard]]
+    auto held_bytes() const -> std::size_t {
+        auto n = 0uz;
+        for (const auto& [size, _] : free_) { n += static_cast<std::size_t>(size); }
+        for (const auto& [_, size] : in_use_) { n += static_cast<std::size_t>(size); }
+        return n;
+    }
+};
+
+} // namespace detail
+
+/// Sorts particles by the grid cell they are in and gives the range of particles of each cell.
+///
+/// Cell of a particle is mapped to a key with the layout mapping of the grid,
+/// so particles are ordered in the same way as the grid points are stored in memory.
+/// Keys are sorted with a parallel stable sort and all components of the particles are permuted
+/// into the double buffer of the particles (see particles::permute).
+/// Scratch memory, including the temporary storage of the sort, is kept in the binner,
+/// so binning every timestep does not allocate unless the number of particles or cells grows.
+class [[nodiscard]] particle_binner {
+    thrust::device_vector<std::size_t> keys_{};
+    thrust::device_vector<std::size_t> permutation_{};
+    thrust::device_vector<std::size_t> offsets_{};
+    detail::caching_temporary_allocator temporary_{};
+
+  public:
+    /// Sorts particles by cell_of(element mdspan), which returns the grid index of the cell
+    /// as std::array<index_type, rank> of the grid.
+    ///
+    /// Afterwards particles of cell with grid offset k = mapping(idx...) are at
+    /// [offsets()[k], offsets()[k + 1]). Particles outside of the grid are not allowed.
+    /// Issued to w and waited for.
+    template<auto ElemDesc, typename Grid, typename CellOf>
+    void sort(particles<ElemDesc>& p, const Grid& grid, CellOf cell_of, const mdgrid_work& w) {
+        const auto mapping   = grid.mds().mapping();
+        const auto num_cells = mapping.required_span_size();
+        const auto n         = p.size();
+
+        keys_.resize(n);
+        permutation_.resize(n);
+        offsets_.resize(num_cells + 1uz);
+
+        w.for_each_index(p.mds(),
+                         [keys = thrust::raw_pointer_cast(keys_.data()),
+                          m    = p.mds(),
+                          mapping,
+                          cell_of](const auto& idx) {
+                             const auto cell = cell_of(m[idx]);
+                             keys[idx[0]]    = [&]<std::size_t... I>(std::index_sequence<I...>) {
+                                 return static_cast<std::size_t>(mapping(cell[I]...));
+                             }(std::make_index_sequence<std::tuple_size_v<decltype(cell)>>());
+                         });
+
+        thrust::sequence(w.on_this(), permutation_.begin(), permutation_.end());
+        thrust::stable_sort_by_key(w.on_this(temporary_),
+                                   keys_.begin(),
+                                   keys_.end(),
+                                   permutation_.begin());
+
+        // Offset of cell k is the first particle with key not less than k.
+        const auto cells = thrust::counting_iterator<std::size_t>(0uz);
+        thrust::lower_bound(w.on_this(temporary_),
+                            keys_.begin(),
+                            keys_.end(),
+                            cells,
+                            cells + static_cast<std::ptrdiff_t>(num_cells + 1uz),
+                            offsets_.begin());
+
+        p.permute(permutation_, w);
+        w.wait();
+    }
+
+    /// Offsets of the cells from the last sort in the device memory, one more than cells.
+    [[nodiscard]]
+    auto offsets() const -> const thrust::device_vector<std::size_t>& {
+        return offsets_;
+    }
+
+    /// Copy of offsets() in host memory.
+    [[nodiscard]]
+    auto host_offsets() const -> thrust::host_vector<std::size_t> {
+        return offsets_;
+    }
+
+    /// Permutation of the last sort: particle i is the old particle permutation()[i].
+    [[nodiscard]]
+    auto permutation() const -> const thrust::device_vector<std::size_t>& {
+        return permutation_;
+    }
+
+    /// Bytes of temporary storage kept for the sort.
+    [[nodiscard]]
+    auto temporary_bytes() const -> std::size_t {
+        return temporary_.held_bytes();
+    }
+};
+
+} // namespace tyvi
@@ -0,0 +1,264 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+#include "thrust/for_each.h"
+#include "thrust/iterator/counting_iterator.h"
+
+#include "tyvi/mdgrid.h"
+#include "tyvi/mdspan.h"
+#include "tyvi/particle_binning.h"
+#include "tyvi/particles.h"
+#include "tyvi/sstd.h"
+
+namespace tyvi {
+
+/// Shape function of a particle: nearest grid point, cloud-in-cell or triangular-shaped cloud.
+enum class shape { nearest, cic, tsc };
+
+/// Number of grid points a particle contributes to in each dimension.
+template<shape S>
+constexpr auto shape_support = S == shape::nearest ? 1uz : S == shape::cic ? 2uz : 3uz;
+
+/// Grid points [first, first + shape_support<S>) and their weights in one dimension.
+template<typename T, shape S>
+struct shape_stencil {
+    std::ptrdiff_t first;
+    std::array<T, shape_support<S>> weights;
+};
+
+/// Stencil of a particle at x in grid units, where grid point i is at x = i.
+///
+/// E.g. with cic a particle at 2.25 gives 0.75 to point 2 and 0.25 to point 3.
+/// Weights sum to one.
+template<shape S, typename T>
+[[nodiscard]]
+constexpr auto
+make_stencil(const T x) -> shape_stencil<T, S> {
+    if constexpr (S == shape::nearest) {
+        const auto i = std::floor(x + T{ 0.5 });
+        return { .first = static_cast<std::ptrdiff_t>(i), .weights{ T{ 1 } } };
+    } else if constexpr (S == shape::cic) {
+        const auto i = std::floor(x);
+        const auto d = x - i;
+        return { .first = static_cast<std::ptrdiff_t>(i), .weights{ T{ 1 } - d, d } };
+    } else {
+        const auto i = std::floor(x + T{ 0.5 });
+        const auto d = x - i;
+        const auto h = T{ 0.5 };
+        return { .first   = static_cast<std::ptrdiff_t>(i) - 1,
+                 .weights = { h * (h - d) * (h - d), T{ 0.75 } - d * d, h * (h + d) * (h + d) } };
+    }
+}
+
+/// Cell function for particle_binner::sort which bins particles as deposit expects:
+/// cell of a particle is the floor of position_of(element mdspan) in each dimension.
+template<typename PositionOf>
+[[nodiscard]]
+constexpr auto
+floor_cell(PositionOf position_of) {
+    return [position_of](const auto& M) {
+        const auto x = position_of(M);
+        auto cell    = std::array<std::size_t, std::tuple_size_v<decltype(x)>>{};
+        for (auto d = 0uz; d < cell.size(); ++d) {
+            cell[d] = static_cast<std::size_t>(std::floor(x[d]));
+        }
+        return cell;
+    };
+}
+
+namespace detail {
+
+/// Number of values in an element of Grid.
+template<typename Grid>
+constexpr auto grid_num_components = [] {
+    using element_extents = typename Grid::element_extents_type;
+    auto n                = 1uz;
+    for (auto i = 0uz; i < element_extents::rank(); ++i) { n *= element_extents::static_extent(i); }
+    return n;
+}();
+
+/// Calls f(grid index, weight) for each point of the tensor product of stencils,
+/// skipping the points outside of extents.
+template<typename T, shape S, std::size_t D, typename Extents, typename F>
+constexpr void
+for_each_stencil_point(const std::array<shape_stencil<T, S>, D>& stencils,
+                       const Extents& extents,
+                       F&& f) {
+    using index_type        = typename Extents::index_type;
+    constexpr auto support  = shape_support<S>;
+    constexpr auto n_points = [] {
+        auto n = 1uz;
+        for (auto d = 0uz; d < D; ++d) { n *= support; }
+        return n;
+    }();
+
+    for (auto p = 0uz; p < n_points; ++p) {
+        auto idx    = std::array<index_type, D>{};
+        auto weight = T{ 1 };
+        auto inside = true;
+        auto r      = p;
+        for (auto d = D; d-- > 0uz;) {
+            const auto o = r % support;
+            r /= support;
+            const auto i = stencils[d].first + static_cast<std::ptrdiff_t>(o);
+            const auto n = static_cast<std::size_t>(extents.extent(d));
+            inside       = inside and i >= 0 and static_cast<std::size_t>(i) < n;
+            idx[d]       = static_cast<index_type>(i);
+            weight *= stencils[d].weights[o];
+        }
+        if (inside) { f(idx, weight); }
+    }
+}
+
+template<shape S, typename T, typename X, std::size_t D>
+[[nodiscard]]
+constexpr auto
+make_stencils(const std::array<X, D>& x) -> std::array<shape_stencil<T, S>, D> {
+    auto stencils = std::array<shape_stencil<T, S>, D>{};
+    for (auto d = 0uz; d < D; ++d) { stencils[d] = make_stencil<S>(static_cast<T>(x[d])); }
+    return stencils;
+}
+
+} // namespace detail
+
+/// Scatter-adds value_of(element mdspan) of each particle with shape S into grid.
+///
+/// position_of(element mdspan) gives position of a particle in grid units
+/// as std::array with one value per grid dimension (see make_stencil).
+/// value_of gives std::array of the grid element components
+/// in the iteration order of sstd::index_space over the element,
+/// e.g. one value for charge on scalar grid and three for current on vector grid.
+/// Contributions to points outside of the grid are dropped, so guard cells are up to caller.
+///
+/// Particles have to be binned by bins over grid with floor_cell(position_of)
+/// after their last move. Deposition is then conflict-free without atomics:
+/// cells are coloured so that stencils of particles in cells of same colour do not overlap,
+/// and cells of each colour are processed in parallel with w, one colour after another.
+/// There are 2^D colours with nearest and cic and 4^D with tsc.
+/// Values are added to the existing values of grid. Issued to w and waited for.
+template<shape S, typename Grid, auto PDesc, typename PositionOf, typename ValueOf>
+void
+deposit(Grid& grid,
+        const particles<PDesc>& p,
+        const particle_binner& bins,
+        PositionOf position_of,
+        ValueOf value_of,
+        const mdgrid_work& w) {
+    using value_type        = typename Grid::value_type;
+    using extents_type      = typename Grid::grid_extents_type;
+    using index_type        = typename extents_type::index_type;
+    constexpr auto D        = extents_type::rank();
+    constexpr auto n_values = detail::grid_num_components<Grid>;
+
+    // Stencil of a particle in cell c is within [c, c + 2) for nearest and cic
+    // and within [c - 1, c + 3) for tsc.
+    constexpr auto stride = S == shape::tsc ? 4uz : 2uz;
+
+    const auto grid_mds = grid.mds();
+    const auto mapping  = grid_mds.mapping();
+    const auto extents  = grid_mds.extents();
+
+    if (bins.offsets().size() != mapping.required_span_size() + 1uz) {
+        throw std::runtime_error{ "Particles are not binned over the deposit grid!" };
+    }
+
+    constexpr auto n_colours = [] {
+        auto n = 1uz;
+        for (auto d = 0uz; d < D; ++d) { n *= stride; }
+        return n;
+    }();
+
+    for (auto colour_id = 0uz; colour_id < n_colours; ++colour_id) {
+        auto colour = std::array<std::size_t, D>{};
+        auto counts = std::array<std::size_t, D>{};
+        auto n      = 1uz;
+        auto r      = colour_id;
+        for (auto d = D; d-- > 0uz;) {
+            colour[d] = r % stride;
+            r /= stride;
+            const auto e = static_cast<std::size_t>(extents.extent(d));
+            counts[d]    = e > colour[d] ? (e - colour[d] + stride - 1uz) / stride : 0uz;
+            n *= counts[d];
+        }
+        if (n == 0) { continue; }
+
+        const auto kernel = [=,
+                             pmds    = p.mds(),
+                             offsets = thrust::raw_pointer_cast(bins.offsets().data())](
+                                const std::size_t linear) {
+            // Cell of the colour with index linear in layout_right order.
+            auto cell = std::array<index_type, D>{};
+            auto r    = linear;
+            for (auto d = D; d-- > 0uz;) {
+                cell[d] = static_cast<index_type>(colour[d] + stride * (r % counts[d]));
+                r /= counts[d];
+            }
+            const auto k = [&]<std::size_t... I>(std::index_sequence<I...>) {
+                return static_cast<std::size_t>(mapping(cell[I]...));
+            }(std::make_index_sequence<D>());
+
+            for (auto q = offsets[k]; q < offsets[k + 1uz]; ++q) {
+                const auto elem     = pmds[q];
+                const auto stencils = detail::make_stencils<S, value_type>(position_of(elem));
+                const auto v        = value_of(elem);
+                static_assert(std::tuple_size_v<decltype(v)> == n_values);
+                detail::for_each_stencil_point(
+                    stencils,
+                    extents,
+                    [&](const auto& idx, const value_type weight) {
+                        const auto grid_elem = grid_mds[idx];
+                        auto c               = 0uz;
+                        for (const auto jdx : sstd::index_space(grid_elem)) {
+                            grid_elem[jdx] += weight * static_cast<value_type>(v[c++]);
+                        }
+                    });
+            }
+        };
+
+        const auto first = thrust::counting_iterator<std::size_t>(0uz);
+        thrust::for_each(w.on_this(), first, first + static_cast<std::ptrdiff_t>(n), kernel);
+    }
+    w.wait();
+}
+
+/// Interpolates grid to each particle with shape S and calls
+/// f(element mdspan, std::array of interpolated grid element components).
+///
+/// Components are in the same order as in deposit and position_of is as in deposit.
+/// Points outside of the grid contribute zero. Particles do not have to be binned,
+/// but binned particles read the grid with better locality. Issued to w.
+template<shape S, typename Grid, auto PDesc, typename PositionOf, typename F>
+const mdgrid_work&
+gather(const Grid& grid,
+       particles<PDesc>& p,
+       PositionOf position_of,
+       F f,
+       const mdgrid_work& w) {
+    using value_type        = typename Grid::value_type;
+    constexpr auto n_values = detail::grid_num_components<Grid>;
+
+    return w.for_each_index(p.mds(), [=, grid_mds = grid.mds(), pmds = p.mds()](const auto& idx) {
+        const auto elem     = pmds[idx];
+        const auto stencils = detail::make_stencils<S, value_type>(position_of(elem));
+
+        auto values = std::array<value_type, n_values>{};
+        detail::for_each_stencil_point(stencils,
+                                       grid_mds.extents(),
+                                       [&](const auto& gidx, const value_type weight) {
+                                           const auto grid_elem = grid_mds[gidx];
+                                           auto c               = 0uz;
+                                           for (const auto jdx : sstd::index_space(grid_elem)) {
+                                               values[c++] += weight * grid_elem[jdx];
+                                           }
+                                       });
+        f(elem, values);
+    });
+}
+
+} // namespace tyvi
@@ -0,0 +1,288 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "thrust/copy.h"
+#include "thrust/device_vector.h"
+#include "thrust/gather.h"
+#include "thrust/host_vector.h"
+#include "thrust/remove.h"
+
+#include "tyvi/huge_pages.h"
+#include "tyvi/mdgrid.h"
+#include "tyvi/mdgrid_buffer.h"
+#include "tyvi/mdspan.h"
+#include "tyvi/memory_registry.h"
+
+namespace tyvi {
+
+/// Dynamically sized set of particles, each of which is an element described by ElemDesc.
+///
+/// Storage is the same as in mdgrid with one dimensional grid of capacity() points:
+/// component-major device and staging buffers, so each component of the elements
+/// is contiguous over the particles. Only the first size() particles are live.
+///
+/// mds() and staging_mds() view the live particles, so they can be given to mdgrid_work
+/// like mdgrids, e.g. mdgrid_work::for_each(particles, f) calls f for each live particle.
+/// mdgrid_work::sync_[to|from]_staging copy whole capacity.
+template<auto ElemDesc>
+class [[nodiscard]] particles {
+  public:
+    using value_type = decltype(ElemDesc)::value_type;
+
+    using element_extents_type = sstd::geometric_extents<ElemDesc.rank, ElemDesc.dim>;
+    using element_layout_type  = std::layout_right;
+
+    using storage_extents_type = std::dextents<std::size_t, 1>;
+    using storage_layout_type  = std::layout_right;
+
+    /// Number of values in each element.
+    static constexpr auto num_components = [] {
+        auto n = 1uz;
+        for (auto i = 0uz; i < ElemDesc.rank; ++i) { n *= ElemDesc.dim; }
+        return n;
+    }();
+
+    using device_vec    = thrust::device_vector<value_type>;
+    using device_buffer = mdgrid_buffer<device_vec,
+                                        element_extents_type,
+                                        element_layout_type,
+                                        storage_extents_type,
+                                        storage_layout_type>;
+
+    using staging_vec    = thrust::host_vector<value_type>;
+    using staging_buffer = mdgrid_buffer<staging_vec,
+                                         element_extents_type,
+                                         element_layout_type,
+                                         storage_extents_type,
+                                         storage_layout_type>;
+
+  private:
+#if defined(TYVI_BACKEND_CPU)
+    /// Device memory is host memory, so both buffers can be backed by huge pages.
+    using device_storage_vec =
+        thrust::device_vector<value_type, huge_pages::device_allocator<value_type>>;
+    using staging_storage_vec = thrust::host_vector<value_type, huge_pages::allocator<value_type>>;
+#else
+    using device_storage_vec  = device_vec;
+    using staging_storage_vec = staging_vec;
+#endif
+
+    using device_storage = mdgrid_buffer<device_storage_vec,
+                                         element_extents_type,
+                                         element_layout_type,
+                                         storage_extents_type,
+                                         storage_layout_type>;
+
+    using staging_storage = mdgrid_buffer<staging_storage_vec,
+                                          element_extents_type,
+                                          element_layout_type,
+                                          storage_extents_type,
+                                          storage_layout_type>;
+
+    device_storage device_buff_;
+    staging_storage staging_buff_;
+    /// Second device buffer for out-of-place permutations, kept to reuse the allocation.
+    device_storage permuted_buff_{ storage_extents_type(0) };
+    std::size_t size_;
+    /// Flags of removed particles, kept between compactions to reuse the allocation.
+    thrust::device_vector<std::uint8_t> removed_{};
+    detail::memory_registration memory_;
+
+    friend class mdgrid_work;
+
+    [[nodiscard]]
+    memory::usage held_bytes_() {
+        return { .device_bytes = device_buff_.span().size_bytes()
+                                 + permuted_buff_.span().size_bytes() + removed_.size(),
+                 .staging_bytes = staging_buff_.span().size_bytes() };
+    }
+
+    /// View of first n elements of a buffer, which keeps the component stride of the buffer.
+    template<typename M>
+    [[nodiscard]]
+    static auto first_(M mds, const std::size_t n) {
+        const auto mapping = typename M::mapping_type(storage_extents_type(n));
+        return M(mds.data_handle(), mapping, mds.accessor());
+    }
+
+    /// Begin of component c in buffer.
+    [[nodiscard]]
+    auto component_(auto& buff, const std::size_t c) const {
+        return buff.begin() + static_cast<std::ptrdiff_t>(c * capacity());
+    }
+
+  public:
+    explicit particles(const std::size_t n = 0)
+        : device_buff_(storage_extents_type(n)),
+          staging_buff_(storage_extents_type(n)),
+          size_{ n },
+          memory_(held_bytes_()) {}
+
+    /// Name used for the particles in tyvi::memory reports.
+    void set_name(std::string name) { memory_.set_name(std::move(name)); }
+
+    [[nodiscard]]
+    std::string name() const {
+        return memory_.name();
+    }
+
+    [[nodiscard]]
+    auto size() const -> std::size_t {
+        return size_;
+    }
+
+    [[nodiscard]]
+    auto empty() const -> bool {
+        return size_ == 0;
+    }
+
+    [[nodiscard]]
+    auto capacity() const -> std::size_t {
+        return device_buff_.grid_extents().extent(0);
+    }
+
+    [[nodiscard]]
+    auto mds() & {
+        return first_(device_buff_.mds(), size_);
+    }
+
+    [[nodiscard]]
+    auto mds() const& {
+        return first_(device_buff_.mds(), size_);
+    }
+
+    [[nodiscard]]
+    auto staging_mds() & {
+        return first_(staging_buff_.mds(), size_);
+    }
+
+    [[nodiscard]]
+    auto staging_mds() const& {
+        return first_(staging_buff_.mds(), size_);
+    }
+
+    /// Grows capacity to at least n, preserving the live particles in both buffers.
+    ///
+    /// Capacity is at least doubled, so growing one particle at a time is amortized O(1).
+    /// Device copies are issued to w and waited for,
+    /// since the old buffers are released at the end.
+    /// Invalidates all pointers, including pointers in [md]spans.
+    void reserve(const std::size_t n, const mdgrid_work& w) {
+        if (n <= capacity()) { return; }
+        reallocate_(std::max(n, 2uz * capacity()), w);
+    }
+
+    /// Sets the number of live particles to n.
+    ///
+    /// New particles have unspecified values.
+    /// Invalidates pointers if capacity grows, see reserve.
+    void resize(const std::size_t n, const mdgrid_work& w) {
+        reserve(n, w);
+        size_ = n;
+    }
+
+    /// Sets capacity to size().
+    void shrink_to_fit(const mdgrid_work& w) {
+        if (capacity() != size_) { reallocate_(size_, w); }
+    }
+
+    /// Removes the particles for which pred(element mdspan) is true from the device buffer.
+    ///
+    /// Removed particles are marked in parallel with w and each component is compacted
+    /// with a parallel stable stream compaction, so the order of remaining particles is kept.
+    /// Staging buffer is not touched. Returns the number of removed particles.
+    template<typename Pred>
+    auto remove_if(Pred pred, const mdgrid_work& w) -> std::size_t {
+        if (size_ == 0) { return 0; }
+
+        if (removed_.size() < size_) {
+            removed_.resize(size_);
+            memory_.update(held_bytes_());
+        }
+        w.for_each_index(mds(),
+                         [removed = thrust::raw_pointer_cast(removed_.data()),
+                          m       = mds(),
+                          pred](const auto& idx) {
+                             removed[idx[0]] = pred(m[idx]) ? std::uint8_t{ 1 } : std::uint8_t{ 0 };
+                         });
+
+        const auto is_removed = [](const std::uint8_t r) { return r != 0; };
+
+        auto remaining = size_;
+        for (auto c = 0uz; c < num_components; ++c) {
+            const auto first = component_(device_buff_, c);
+            const auto last  = first + static_cast<std::ptrdiff_t>(size_);
+            const auto end =
+                thrust::remove_if(w.on_this(), first, last, removed_.begin(), is_removed);
+            remaining = static_cast<std::size_t>(end - first);
+        }
+
+        const auto n_removed = size_ - remaining;
+        size_                = remaining;
+        return n_removed;
+    }
+
+    /// Reorders the live particles in the device buffer,
+    /// so that particle i becomes the old particle perm[i].
+    ///
+    /// perm is a device vector of at least size() indices, e.g. from sorting.
+    /// Throws if perm is shorter.
+    /// Each component is gathered in parallel into a second device buffer
+    /// which then becomes the device buffer, so the old one is reused by the next permutation.
+    /// Invalidates all pointers to the device buffer, including pointers in [md]spans.
+    template<typename Perm>
+    void permute(const Perm& perm, const mdgrid_work& w) {
+        if (perm.size() < size_) {
+            throw std::runtime_error{ std::format(
+                "Permutation of {} indices is too short for {} particles!", perm.size(), size_) };
+        }
+
+        if (permuted_buff_.grid_extents().extent(0) != capacity()) {
+            permuted_buff_ = device_storage(storage_extents_type(capacity()));
+            memory_.update(held_bytes_());
+        }
+
+        const auto n = static_cast<std::ptrdiff_t>(size_);
+        for (auto c = 0uz; c < num_components; ++c) {
+            thrust::gather(w.on_this(),
+                           perm.begin(),
+                           perm.begin() + n,
+                           component_(device_buff_, c),
+                           component_(permuted_buff_, c));
+        }
+
+        std::swap(device_buff_, permuted_buff_);
+    }
+
+  private:
+    void reallocate_(const std::size_t new_capacity, const mdgrid_work& w) {
+        auto device  = device_storage(storage_extents_type(new_capacity));
+        auto staging = staging_storage(storage_extents_type(new_capacity));
+
+        const auto n = static_cast<std::ptrdiff_t>(size_);
+        for (auto c = 0uz; c < num_components; ++c) {
+            const auto offset = static_cast<std::ptrdiff_t>(c * new_capacity);
+
+            const auto device_first = component_(device_buff_, c);
+            thrust::copy(w.on_this(), device_first, device_first + n, device.begin() + offset);
+
+            const auto staging_first = component_(staging_buff_, c);
+            std::copy(staging_first, staging_first + n, staging.begin() + offset);
+        }
+        w.wait();
+
+        device_buff_   = std::move(device);
+        staging_buff_  = std::move(staging);
+        permuted_buff_ = device_storage(storage_extents_type(0));
+        memory_.update(held_bytes_());
+    }
+};
+
+} // namespace tyvi
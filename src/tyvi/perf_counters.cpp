@@ -0,0 +1,328 @@
+#include "tyvi/perf_counters.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <functional>
+#include <mutex>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "tyvi/sstd.h"
+
+#if defined(TYVI_ENABLE_PERF_COUNTERS)
+#    include <linux/perf_event.h>
+#    include <sys/ioctl.h>
+#    include <sys/syscall.h>
+#    include <unistd.h>
+#endif
+
+namespace {
+
+namespace tpc = tyvi::perf_counters;
+
+[[nodiscard]]
+constexpr auto
+ratio(const double numerator, const double denominator) -> double {
+    return denominator == 0.0 ? 0.0 : numerator / denominator;
+}
+
+#if defined(TYVI_ENABLE_PERF_COUNTERS)
+
+/// Events counted in the group, i.e. all except dTLB misses.
+constexpr auto num_group_events = tpc::num_events - 1uz;
+
+/// Hardware counters of the calling thread opened as one group,
+/// so that they are scheduled on the PMU together.
+///
+/// dTLB counter is opened on its own, so that the group fits into
+/// the general purpose counters and is not lost if dTLB events are not supported.
+class counter_group : tyvi::sstd::immovable {
+    std::array<int, num_group_events> fds_{};
+    int tlb_fd_{ -1 };
+    bool valid_{ false };
+
+    [[nodiscard]]
+    static auto open_(const std::uint32_t type,
+                      const std::uint64_t config,
+                      const int group_fd,
+                      const std::uint64_t read_format) -> int {
+        auto attr           = perf_event_attr{};
+        attr.type           = type;
+        attr.size           = sizeof(perf_event_attr);
+        attr.config         = config;
+        attr.disabled       = group_fd == -1 ? 1 : 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv     = 1;
+        attr.read_format    = read_format;
+
+        // Measure calling thread on any cpu.
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0));
+    }
+
+  public:
+    counter_group() {
+        // Order has to match tpc::event.
+        static constexpr auto configs =
+            std::array<std::uint64_t, num_group_events>{ PERF_COUNT_HW_CPU_CYCLES,
+                                                         PERF_COUNT_HW_INSTRUCTIONS,
+                                                         PERF_COUNT_HW_CACHE_REFERENCES,
+                                                         PERF_COUNT_HW_CACHE_MISSES,
+                                                         PERF_COUNT_HW_BRANCH_INSTRUCTIONS,
+                                                         PERF_COUNT_HW_BRANCH_MISSES };
+
+        static constexpr auto dtlb_load_misses =
+            std::uint64_t{ PERF_COUNT_HW_CACHE_DTLB }
+            | (std::uint64_t{ PERF_COUNT_HW_CACHE_OP_READ } << 8u)
+            | (std::uint64_t{ PERF_COUNT_HW_CACHE_RESULT_MISS } << 16u);
+
+        tlb_fd_ = open_(PERF_TYPE_HW_CACHE, dtlb_load_misses, -1, 0);
+        if (tlb_fd_ != -1) {
+            ioctl(tlb_fd_, PERF_EVENT_IOC_RESET, 0);
+            ioctl(tlb_fd_, PERF_EVENT_IOC_ENABLE, 0);
+        }
+
+        fds_.fill(-1);
+        for (auto i = 0uz; i < num_group_events; ++i) {
+            fds_[i] = open_(PERF_TYPE_HARDWARE,
+                            configs[i],
+                            i == 0 ? -1 : fds_[0],
+                            PERF_FORMAT_GROUP);
+            if (fds_[i] == -1) { return; }
+        }
+
+        ioctl(fds_[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(fds_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        valid_ = true;
+    }
+
+    ~counter_group() {
+        for (const auto fd : fds_) {
+            if (fd != -1) { close(fd); }
+        }
+        if (tlb_fd_ != -1) { close(tlb_fd_); }
+    }
+
+    [[nodiscard]]
+    auto read() const -> tyvi::detail::counter_snapshot {
+        auto snapshot =
+            tyvi::detail::counter_snapshot{ .counters{}, .valid = false, .tlb_valid = false };
+
+        auto tlb_misses = std::uint64_t{ 0 };
+        if (tlb_fd_ != -1) {
+            const auto n       = ::read(tlb_fd_, &tlb_misses, sizeof(tlb_misses));
+            snapshot.tlb_valid = n == static_cast<ssize_t>(sizeof(tlb_misses));
+            snapshot.counters[tpc::event::dtlb_load_misses] = tlb_misses;
+        }
+
+        if (not valid_) { return snapshot; }
+
+        // Layout defined by PERF_FORMAT_GROUP.
+        struct {
+            std::uint64_t nr;
+            std::array<std::uint64_t, num_group_events> values;
+        } group{};
+
+        const auto n = ::read(fds_[0], &group, sizeof(group));
+        if (n != static_cast<ssize_t>(sizeof(group)) or group.nr != num_group_events) {
+            return snapshot;
+        }
+
+        std::ranges::copy(group.values, snapshot.counters.values.begin());
+        snapshot.valid = true;
+        return snapshot;
+    }
+};
+
+class profile_registry : tyvi::sstd::immovable {
+    std::mutex mutex_;
+    std::unordered_map<std::string, tpc::kernel_profile> profiles_;
+
+  public:
+    void record(const std::string_view label,
+                const std::size_t bytes,
+                const std::chrono::nanoseconds time,
+                const tyvi::detail::counter_snapshot& begin,
+                const tyvi::detail::counter_snapshot& end) {
+        [[maybe_unused]]
+        const std::scoped_lock _{ mutex_ };
+
+        auto [it, is_new] = profiles_.try_emplace(std::string{ label });
+        auto& p           = it->second;
+
+        if (is_new) {
+            p.label                 = label;
+            p.counters_available    = true;
+            p.tlb_counter_available = true;
+        }
+
+        ++p.invocations;
+        p.time += time;
+        p.bytes += bytes;
+
+        if (begin.valid and end.valid) {
+            for (auto i = 0uz; i < num_group_events; ++i) {
+                p.counters.values[i] += end.counters.values[i] - begin.counters.values[i];
+            }
+        } else {
+            p.counters_available = false;
+        }
+
+        if (begin.tlb_valid and end.tlb_valid) {
+            p.counters[tpc::event::dtlb_load_misses] +=
+                end.counters[tpc::event::dtlb_load_misses]
+                - begin.counters[tpc::event::dtlb_load_misses];
+        } else {
+            p.tlb_counter_available = false;
+        }
+    }
+
+    [[nodiscard]]
+    auto profiles() -> std::vector<tpc::kernel_profile> {
+        [[maybe_unused]]
+        const std::scoped_lock _{ mutex_ };
+
+        auto result = std::vector<tpc::kernel_profile>{};
+        result.reserve(profiles_.size());
+        for (const auto& p : profiles_ | std::views::values) { result.push_back(p); }
+        return result;
+    }
+
+    void clear() {
+        [[maybe_unused]]
+        const std::scoped_lock _{ mutex_ };
+        profiles_.clear();
+    }
+};
+
+[[nodiscard]]
+profile_registry&
+registry() {
+    static profile_registry r{};
+    return r;
+}
+
+#endif
+
+} // namespace
+
+namespace tyvi::perf_counters {
+
+auto
+kernel_profile::ipc() const -> double {
+    return ratio(static_cast<double>(counters[event::instructions]),
+                 static_cast<double>(counters[event::cycles]));
+}
+
+auto
+kernel_profile::cache_miss_rate() const -> double {
+    return ratio(static_cast<double>(counters[event::cache_misses]),
+                 static_cast<double>(counters[event::cache_references]));
+}
+
+auto
+kernel_profile::branch_miss_rate() const -> double {
+    return ratio(static_cast<double>(counters[event::branch_misses]),
+                 static_cast<double>(counters[event::branch_instructions]));
+}
+
+auto
+kernel_profile::dtlb_misses_per_page() const -> double {
+    return ratio(static_cast<double>(counters[event::dtlb_load_misses]),
+                 static_cast<double>(bytes) / static_cast<double>(regular_page_size));
+}
+
+auto
+kernel_profile::achieved_bandwidth() const -> double {
+    // bytes / ns = GB/s
+    return ratio(static_cast<double>(bytes), static_cast<double>(time.count()));
+}
+
+auto
+kernel_profile::estimated_memory_bandwidth() const -> double {
+    const auto traffic = counters[event::cache_misses] * cache_line_size;
+    return ratio(static_cast<double>(traffic), static_cast<double>(time.count()));
+}
+
+auto
+profiles() -> std::vector<kernel_profile> {
+#if defined(TYVI_ENABLE_PERF_COUNTERS)
+    auto p = registry().profiles();
+    std::ranges::sort(p, std::ranges::greater{}, &kernel_profile::time);
+    return p;
+#else
+    return {};
+#endif
+}
+
+void
+clear() {
+#if defined(TYVI_ENABLE_PERF_COUNTERS)
+    registry().clear();
+#endif
+}
+
+void
+write_report(std::ostream& os) {
+    os << std::format("{:<32} {:>8} {:>12} {:>6} {:>10} {:>10} {:>12} {:>14} {:>10}\n",
+                      "label",
+                      "calls",
+                      "time [us]",
+                      "IPC",
+                      "cache miss",
+                      "br. miss",
+                      "BW [GB/s]",
+                      "LLC BW [GB/s]",
+                      "dTLB/page");
+
+    for (const auto& p : profiles()) {
+        const auto us  = std::chrono::duration<double, std::micro>(p.time).count();
+        const auto tlb = p.tlb_counter_available ? std::format("{:.3f}", p.dtlb_misses_per_page())
+                                                 : std::string{ "-" };
+
+        os << std::format("{:<32} {:>8} {:>12.1f} ", p.label, p.invocations, us);
+        if (p.counters_available) {
+            os << std::format("{:>6.2f} {:>10.3f} {:>10.3f} {:>12.2f} {:>14.2f} ",
+                              p.ipc(),
+                              p.cache_miss_rate(),
+                              p.branch_miss_rate(),
+                              p.achieved_bandwidth(),
+                              p.estimated_memory_bandwidth());
+        } else {
+            os << std::format("{:>6} {:>10} {:>10} {:>12.2f} {:>14} ",
+                              "-",
+                              "-",
+                              "-",
+                              p.achieved_bandwidth(),
+                              "-");
+        }
+        os << std::format("{:>10}\n", tlb);
+    }
+}
+
+} // namespace tyvi::perf_counters
+
+#if defined(TYVI_ENABLE_PERF_COUNTERS)
+
+auto
+tyvi::detail::read_counters() -> counter_snapshot {
+    static thread_local const counter_group group{};
+    return group.read();
+}
+
+void
+tyvi::detail::record_counters(const std::string_view label,
+                              const std::size_t bytes,
+                              const std::chrono::nanoseconds time,
+                              const counter_snapshot& begin,
+                              const counter_snapshot& end) {
+    registry().record(label, bytes, time, begin, end);
+}
+
+#endif
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace tyvi::perf_counters {
+
+/// True if tyvi is build with tyvi_ENABLE_PERF_COUNTERS.
+#if defined(TYVI_ENABLE_PERF_COUNTERS)
+static constexpr bool enabled = true;
+#else
+static constexpr bool enabled = false;
+#endif
+
+/// Hardware events which are counted around each mdgrid_work operation.
+enum class event : std::uint8_t {
+    cycles,
+    instructions,
+    cache_references,
+    cache_misses,
+    branch_instructions,
+    branch_misses,
+    /// Counted separately from the other events, see kernel_profile::tlb_counter_available.
+    dtlb_load_misses
+};
+
+static constexpr auto num_events = 7uz;
+
+/// Size of regular page used when normalizing TLB misses.
+static constexpr auto regular_page_size = 4096uz;
+
+/// Assumed size of cache line when estimating memory traffic from cache misses.
+static constexpr auto cache_line_size = 64uz;
+
+struct counter_values {
+    std::array<std::uint64_t, num_events> values{};
+
+    [[nodiscard]]
+    constexpr auto operator[](const event e) const -> std::uint64_t {
+        return values[static_cast<std::size_t>(e)];
+    }
+
+    [[nodiscard]]
+    constexpr auto operator[](const event e) -> std::uint64_t& {
+        return values[static_cast<std::size_t>(e)];
+    }
+
+    constexpr auto operator+=(const counter_values& rhs) -> counter_values& {
+        for (auto i = 0uz; i < num_events; ++i) { values[i] += rhs.values[i]; }
+        return *this;
+    }
+};
+
+/// Aggregated counters of all mdgrid_work operations with the same label.
+struct kernel_profile {
+    std::string label;
+    std::size_t invocations{};
+    std::chrono::nanoseconds time{};
+    /// Sum of bytes the operations have to move, based on the touched grids.
+    std::size_t bytes{};
+    counter_values counters{};
+    /// False if the counters could not be opened (see /proc/sys/kernel/perf_event_paranoid).
+    bool counters_available{};
+    /// False if the dTLB counter could not be opened, e.g. it is not supported in virtual machines.
+    bool tlb_counter_available{};
+
+    /// Instructions per cycle.
+    [[nodiscard]]
+    auto ipc() const -> double;
+
+    [[nodiscard]]
+    auto cache_miss_rate() const -> double;
+
+    [[nodiscard]]
+    auto branch_miss_rate() const -> double;
+
+    /// dTLB load misses per regular page of bytes the operations have to move.
+    ///
+    /// Grids streamed through regular pages are expected to have about one,
+    /// and grids backed by huge pages (see tyvi::huge_pages) much less.
+    [[nodiscard]]
+    auto dtlb_misses_per_page() const -> double;
+
+    /// Bytes the operations have to move divided by the elapsed time [GB/s].
+    [[nodiscard]]
+    auto achieved_bandwidth() const -> double;
+
+    /// Memory traffic estimated from last level cache misses divided by the elapsed time [GB/s].
+    [[nodiscard]]
+    auto estimated_memory_bandwidth() const -> double;
+};
+
+/// Get profiles of all labels recorded since the last clear.
+///
+/// Always empty if counters are disabled.
+[[nodiscard]]
+auto profiles() -> std::vector<kernel_profile>;
+
+/// Discard all recorded profiles.
+void clear();
+
+/// Write human readable table of the recorded profiles.
+void write_report(std::ostream& os);
+
+} // namespace tyvi::perf_counters
+
+namespace tyvi::detail {
+
+#if defined(TYVI_ENABLE_PERF_COUNTERS)
+/// Current counter values of the calling thread.
+///
+/// Counters are opened lazily for each thread.
+/// If they can not be opened, returned snapshot is not valid.
+struct counter_snapshot {
+    perf_counters::counter_values counters;
+    bool valid;
+    /// Validity of perf_counters::event::dtlb_load_misses.
+    bool tlb_valid;
+};
+
+[[nodiscard]]
+auto read_counters() -> counter_snapshot;
+
+void record_counters(std::string_view label,
+                     std::size_t bytes,
+                     std::chrono::nanoseconds time,
+                     const counter_snapshot& begin,
+                     const counter_snapshot& end);
+#endif
+
+} // namespace tyvi::detail
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <concepts>
+#include <cstddef>
 #include <ranges>
 #include <stdexcept>
 
@@ -20,6 +21,13 @@ ipow(const T base, const T exponent) {
     return result;
 }
 
+/// Mixes hash of a value into seed (boost::hash_combine).
+[[nodiscard]]
+constexpr std::size_t
+hash_combine(const std::size_t seed, const std::size_t value) {
+    return seed ^ (value + 0x9e3779b97f4a7c15uz + (seed << 6uz) + (seed >> 2uz));
+}
+
 struct immovable {
     constexpr immovable()           = default;
     constexpr ~immovable() noexcept = default;
@@ -0,0 +1,90 @@
+#include <boost/ut.hpp> // import boost.ut;
+
+#include <cstdint>
+#include <numeric>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "tyvi/actions_arena.h"
+#include "tyvi/actions_ast.h"
+#include "tyvi/actions_eval.h"
+#include "tyvi/actions_list.h"
+#include "tyvi/execution.h"
+
+namespace {
+using namespace boost::ut;
+namespace ta = tyvi::actions;
+namespace te = tyvi::exec;
+using namespace std::literals;
+
+[[maybe_unused]]
+const suite<"actions_arena"> _ = [] {
+    enum class action : std::uint8_t { iota };
+
+    "lists are allocated from bound arena"_test = [] {
+        auto arena = ta::node_arena{};
+        expect(ta::node_resource() == nullptr);
+
+        auto xs = std::vector<int>(100);
+        std::ranges::iota(xs, 0);
+
+        {
+            const auto _ = ta::node_resource_scope(&arena);
+            expect(ta::node_resource() == &arena);
+
+            const auto list = ta::list(std::from_range, xs);
+            expect(arena.allocated_bytes() >= xs.size() * sizeof(ta::detail::cons_node));
+        }
+
+        expect(ta::node_resource() == nullptr);
+    };
+
+    "cells outlive the scope but not the arena"_test = [] {
+        auto arena = ta::node_arena{};
+
+        auto list = ta::sexpr{};
+        {
+            const auto _ = ta::node_resource_scope(&arena);
+            list         = ta::list(1, 2, 3);
+        }
+
+        const auto bytes = arena.allocated_bytes();
+        const auto other = ta::list(4, 5, 6);
+        expect(arena.allocated_bytes() == bytes);
+
+        expect(std::visit(ta::list_append, list, other) == ta::list(1, 2, 3, 4, 5, 6));
+    };
+
+    "eval continuations allocate from the arena"_test = [] {
+        const auto iota = ta::sync_procedure([](const ta::sexpr& args) -> ta::sexpr {
+            const auto n = ta::atom_get<int>(std::get<ta::atom>(std::get<ta::cons>(args).car()));
+            auto v       = std::vector<int>(static_cast<std::size_t>(n));
+            std::ranges::iota(v, 0);
+            return ta::list(std::from_range, v);
+        });
+
+        auto arena = ta::node_arena{};
+
+        const auto env = ta::list(ta::cons(action::iota, iota));
+        const auto src = ta::list(action::iota, 50);
+
+        auto snd = [&] {
+            const auto _ = ta::node_resource_scope(&arena);
+            return ta::eval<action>(src, env);
+        }();
+
+        const auto before = arena.allocated_bytes();
+        const auto x      = tyvi::this_thread::sync_wait(std::move(snd));
+
+        expect(arena.allocated_bytes() >= before + 50uz * sizeof(ta::detail::cons_node));
+        expect(std::get<ta::cons>(x).car() == ta::sexpr{ 0 });
+    };
+};
+
+} // namespace
+
+int
+main(int argc, const char** argv) {
+    return static_cast<int>(cfg<override>.run(run_cfg{ .argc = argc, .argv = argv }));
+}
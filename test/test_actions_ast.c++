@@ -1,8 +1,10 @@
 #include "constant_testing.h"
 #include <boost/ut.hpp> // import boost.ut;
 
+#include <stdexcept>
 #include <string>
 #include <string_view>
+#include <tuple>
 #include <utility>
 #include <variant>
 
@@ -294,6 +296,21 @@ const suite<"actions_ast"> _ = [] {
         });
     };
 
+    "cons copies share structure"_test = []() {
+        tyvi::constant_testing([](auto& tester) static consteval {
+            const auto a = ta::cons("foo"s, ta::cons(ta::cons("foo"s, 3), 4));
+            auto b       = a;
+
+            tester.expect(&a.car() == &b.car());
+            tester.expect(&a.cdr() == &b.cdr());
+
+            b = ta::cons("bar"s, b.cdr());
+            tester.expect(a != b);
+            tester.expect(&std::get<ta::cons>(a.cdr()).car() == &std::get<ta::cons>(b.cdr()).car());
+            tester.expect(std::get<ta::atom>(a.car()) == ta::atom{ "foo"s });
+        });
+    };
+
     "atom_is_of_type"_test = []() {
         tyvi::constant_testing([](auto& tester) static consteval {
             const auto a = ta::atom{ "foo"s };
@@ -313,6 +330,58 @@ const suite<"actions_ast"> _ = [] {
             tester.expect(ta::atom_is_of_type<int, char, std::string>(c));
         });
     };
+
+    "atom_get"_test = []() {
+        tyvi::constant_testing([](auto& tester) static consteval {
+            const auto a = ta::atom{ "foo"s };
+            const auto b = ta::atom{ 1 };
+
+            tester.expect(ta::atom_get<std::string>(a) == "foo");
+            tester.expect(ta::atom_get<int>(b) == 1);
+            tester.expect(ta::atom_get_if<int>(a) == nullptr);
+            tester.expect(ta::atom_get_if<std::string>(b) == nullptr);
+            tester.expect(&ta::atom_get<std::string>(a) == ta::atom_get_if<std::string>(a));
+        });
+
+        expect(throws<std::runtime_error>(
+            [] { std::ignore = ta::atom_get<int>(ta::atom{ 'c' }); }));
+    };
+
+    "small atoms at runtime"_test = []() {
+        static_assert(sizeof(ta::atom) <= 3uz * sizeof(void*));
+
+        auto a       = ta::atom{ 42 };
+        const auto b = ta::atom{ 42.0 };
+        const auto c = ta::atom{ ta::intrinsic::quote };
+
+        expect(ta::atom_get<int>(a) == 42);
+        expect(ta::atom_get<double>(b) == 42.0);
+        expect(ta::atom_get<ta::intrinsic>(c) == ta::intrinsic::quote);
+        expect(a != b);
+
+        const auto A = a;
+        expect(A == a);
+        expect(ta::atom_get_if<int>(A) != ta::atom_get_if<int>(a));
+
+        auto s = ta::atom{ "a string which does not fit inline"s };
+        swap(a, s);
+        expect(ta::atom_get<std::string>(a) == "a string which does not fit inline");
+        expect(ta::atom_get<int>(s) == 42);
+
+        const auto moved = std::move(s);
+        expect(ta::atom_get<int>(moved) == 42);
+    };
+
+    "procedure atoms compare by identity"_test = []() {
+        const auto f = ta::atom{ ta::procedure{ [](ta::sexpr x) -> ta::sexpr_sender {
+            return tyvi::exec::just(std::move(x));
+        } } };
+        const auto g = f;
+
+        expect(f == f);
+        expect(f != g);
+        expect(ta::atom_get_if<ta::procedure>(f) != nullptr);
+    };
 };
 
 } // namespace
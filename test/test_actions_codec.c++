@@ -0,0 +1,140 @@
+#include <boost/ut.hpp> // import boost.ut;
+
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <string>
+#include <tuple>
+#include <variant>
+#include <vector>
+
+#include "tyvi/actions_arena.h"
+#include "tyvi/actions_ast.h"
+#include "tyvi/actions_codec.h"
+#include "tyvi/actions_list.h"
+
+namespace {
+using namespace boost::ut;
+namespace ta = tyvi::actions;
+using namespace std::literals;
+
+[[maybe_unused]]
+const suite<"actions_codec"> _ = [] {
+    enum class action : std::uint8_t { append, foobar };
+
+    const auto round_trip = [](const ta::sexpr& s, const ta::codec_registry& reg) {
+        return ta::decode(ta::encode(s, reg), reg);
+    };
+
+    "builtin atoms round trip"_test = [&] {
+        const auto reg = ta::codec_registry{};
+
+        expect(round_trip(ta::null, reg) == ta::sexpr{ ta::null });
+        expect(round_trip(42, reg) == ta::sexpr{ 42 });
+        expect(round_trip(1.5, reg) == ta::sexpr{ 1.5 });
+        expect(round_trip(true, reg) == ta::sexpr{ true });
+        expect(round_trip("foobar"s, reg) == ta::sexpr{ "foobar"s });
+        expect(round_trip(""s, reg) == ta::sexpr{ ""s });
+        expect(round_trip(ta::intrinsic::quote, reg) == ta::sexpr{ ta::intrinsic::quote });
+    };
+
+    "lists round trip"_test = [&] {
+        const auto reg = ta::codec_registry{};
+
+        const auto nested = ta::list(1, ta::list("a"s, ta::list(2.0)), ta::null);
+        expect(round_trip(nested, reg) == nested);
+
+        const auto improper = ta::cons(1, ta::cons(2, 3));
+        expect(round_trip(improper, reg) == ta::sexpr{ improper });
+
+        auto xs = std::vector<int>(10'000);
+        std::ranges::iota(xs, 0);
+        const auto long_list = ta::list(std::from_range, xs);
+        expect(round_trip(long_list, reg) == long_list);
+    };
+
+    "registered symbols round trip"_test = [&] {
+        auto reg = ta::codec_registry{};
+        reg.add<action>(ta::codec_registry::first_user_tag);
+
+        const auto program = ta::list(action::append, ta::list(action::foobar, "x"s));
+        expect(round_trip(program, reg) == program);
+
+        expect(throws([&] { reg.add<action>(ta::codec_registry::first_user_tag + 1); }));
+        expect(throws([&] { reg.add<float>(ta::codec_registry::first_user_tag); }));
+    };
+
+    "encoding is compact"_test = [] {
+        auto reg = ta::codec_registry{};
+        reg.add<action>(ta::codec_registry::first_user_tag);
+
+        // version, list, length, 3 * (atom, tag, size, payload), null tail
+        const auto program = ta::list(action::append, action::foobar, action::append);
+        const auto bytes   = ta::encode(program, reg);
+        expect(bytes.size() == 1uz + 1uz + 1uz + 3uz * 4uz + 1uz);
+    };
+
+    "unregistered and malformed input throws"_test = [] {
+        const auto reg = ta::codec_registry{};
+        expect(throws([&] { std::ignore = ta::encode(ta::list(action::append), reg); }));
+
+        auto bytes = ta::encode(ta::list(1, 2, 3), reg);
+        expect(nothrow([&] { std::ignore = ta::decode(bytes, reg); }));
+
+        auto truncated = bytes;
+        truncated.pop_back();
+        expect(throws([&] { std::ignore = ta::decode(truncated, reg); }));
+
+        auto trailing = bytes;
+        trailing.push_back(std::byte{ 0 });
+        expect(throws([&] { std::ignore = ta::decode(trailing, reg); }));
+
+        const auto other = ta::codec_registry{};
+        auto with_symbol = other;
+        with_symbol.add<action>(ta::codec_registry::first_user_tag);
+        const auto symbol_bytes = ta::encode(ta::list(action::append), with_symbol);
+        expect(throws([&] { std::ignore = ta::decode(symbol_bytes, other); }));
+
+        auto bad_bool = ta::encode(true, reg);
+        bad_bool.back() = std::byte{ 2 };
+        expect(throws([&] { std::ignore = ta::decode(bad_bool, reg); }));
+    };
+
+    "deeply nested input throws instead of overflowing"_test = [] {
+        const auto reg = ta::codec_registry{};
+
+        // List whose tail is a list and so on, nested depth times.
+        const auto nested = [](const std::size_t depth) {
+            auto bytes = std::vector<std::byte>{ std::byte{ 1 } };
+            for (auto i = 0uz; i < depth; ++i) {
+                bytes.push_back(std::byte{ 2 });
+                bytes.push_back(std::byte{ 0 });
+            }
+            bytes.push_back(std::byte{ 0 });
+            return bytes;
+        };
+
+        expect(nothrow([&] { std::ignore = ta::decode(nested(100), reg); }));
+        expect(throws([&] { std::ignore = ta::decode(nested(1'000'000), reg); }));
+    };
+
+    "decoding allocates cells from given resource"_test = [] {
+        const auto reg   = ta::codec_registry{};
+        const auto bytes = ta::encode(ta::list(1, ta::list(2, 3), 4), reg);
+
+        auto arena = ta::node_arena{};
+        {
+            const auto decoded = ta::decode(bytes, reg, &arena);
+            expect(decoded == ta::list(1, ta::list(2, 3), 4));
+            expect(arena.allocated_bytes() >= 5uz * sizeof(ta::detail::cons_node));
+        }
+        expect(ta::node_resource() == nullptr);
+    };
+};
+
+} // namespace
+
+int
+main(int argc, const char** argv) {
+    return static_cast<int>(cfg<override>.run(run_cfg{ .argc = argc, .argv = argv }));
+}
@@ -0,0 +1,119 @@
+#include <boost/ut.hpp> // import boost.ut;
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <variant>
+
+#include "tyvi/actions_ast.h"
+#include "tyvi/actions_compile.h"
+#include "tyvi/actions_list.h"
+#include "tyvi/execution.h"
+
+namespace {
+using namespace boost::ut;
+namespace ta = tyvi::actions;
+namespace te = tyvi::exec;
+using namespace std::literals;
+using ti = ta::intrinsic;
+
+[[maybe_unused]]
+const suite<"actions_compile"> _ = [] {
+    enum class action : std::uint8_t { append, foobar, unbound };
+
+    static constexpr auto make_concatter = [](std::string& str) {
+        return [&](ta::sexpr args) -> ta::sexpr_sender {
+            return te::just(std::move(args)) | te::then([&](const ta::sexpr& s) -> ta::sexpr {
+                       for (const auto& x : ta::list_view(s)) {
+                           str += ta::atom_get<std::string>(std::get<ta::atom>(x));
+                       }
+                       return ta::null;
+                   });
+        };
+    };
+
+    "symbols and quotes are folded into constants"_test = [] {
+        const auto env = ta::list(ta::cons(action::foobar, "foobar"s));
+
+        const auto a = ta::compile<action>(action::foobar, env);
+        const auto b = ta::compile(ta::list(ti::quote, ta::cons(42, 43)), ta::list());
+
+        expect(a.constant() != nullptr);
+        expect(b.constant() != nullptr);
+        expect(tyvi::this_thread::sync_wait(a.run()) == ta::sexpr{ "foobar"s });
+        expect(tyvi::this_thread::sync_wait(b.run()) == ta::sexpr{ ta::cons(42, 43) });
+    };
+
+    "plan can be run multiple times"_test = [] {
+        auto str = std::string{};
+
+        const auto env = ta::list(ta::cons(action::append, ta::procedure(make_concatter(str))));
+        const auto src = ta::list(action::append, "foo"s, "bar"s);
+
+        const auto p = ta::compile<action>(src, env);
+        expect(p.constant() == nullptr);
+
+        tyvi::this_thread::sync_wait(p.run());
+        expect(str == "foobar");
+        tyvi::this_thread::sync_wait(p.run());
+        expect(str == "foobarfoobar");
+    };
+
+    "nested calls give same result as eval"_test = [] {
+        auto str = std::string{};
+
+        const auto env = ta::list(ta::cons(action::append, ta::procedure(make_concatter(str))));
+
+        auto list      = ta::list(ti::quote, ta::list("foo"s, "bar"s, "xyz"s));
+        auto bar       = ta::list(ti::car, ta::list(ti::cdr, std::move(list)));
+        const auto src = ta::list(action::append, std::move(bar), "xyz"s);
+
+        tyvi::this_thread::sync_wait(ta::compile<action>(src, env).run());
+        expect(str == "barxyz");
+    };
+
+    "sender does not need the plan to be alive"_test = [] {
+        auto snd = ta::compile(ta::list(ti::car, ta::list(ti::quote, ta::cons(42, 43))), ta::list())
+                       .run();
+        expect(std::get<ta::atom>(tyvi::this_thread::sync_wait(std::move(snd))) == ta::atom{ 42 });
+    };
+
+    "sync procedures are run inline"_test = [] {
+        auto calls = 0;
+
+        const auto add = ta::sync_procedure([&](const ta::sexpr& args) -> ta::sexpr {
+            ++calls;
+            auto sum = 0;
+            for (const auto& x : ta::list_view(args)) {
+                sum += ta::atom_get<int>(std::get<ta::atom>(x));
+            }
+            return sum;
+        });
+
+        const auto env = ta::list(ta::cons(action::foobar, add));
+        const auto src = ta::list(action::foobar, 1, ta::list(action::foobar, 2, 3));
+        const auto p   = ta::compile<action>(src, env);
+
+        expect(std::get<ta::atom>(tyvi::this_thread::sync_wait(p.run())) == ta::atom{ 6 });
+        expect(std::get<ta::atom>(tyvi::this_thread::sync_wait(p.run())) == ta::atom{ 6 });
+        expect(calls == 4);
+    };
+
+    "errors are reported at compile time"_test = [] {
+        expect(throws<std::runtime_error>(
+            [] { std::ignore = ta::compile<action>(ta::list(action::unbound), ta::list()); }));
+        expect(throws<std::runtime_error>(
+            [] { std::ignore = ta::compile(ta::list(ti::quote, 1, 2), ta::list()); }));
+        expect(throws<std::runtime_error>(
+            [] { std::ignore = ta::compile(ta::list(42, "foo"s), ta::list()); }));
+        expect(throws<std::runtime_error>(
+            [] { std::ignore = ta::compile(ta::sexpr{ ta::cons(ti::car, 42) }, ta::list()); }));
+    };
+};
+
+} // namespace
+
+int
+main(int argc, const char** argv) {
+    return static_cast<int>(cfg<override>.run(run_cfg{ .argc = argc, .argv = argv }));
+}
@@ -0,0 +1,81 @@
+#include <boost/ut.hpp> // import boost.ut;
+
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <variant>
+
+#include "tyvi/actions_ast.h"
+#include "tyvi/actions_environment.h"
+#include "tyvi/actions_eval.h"
+#include "tyvi/actions_list.h"
+#include "tyvi/execution.h"
+
+namespace {
+using namespace boost::ut;
+namespace ta = tyvi::actions;
+using namespace std::literals;
+
+[[maybe_unused]]
+const suite<"actions_environment"> _ = [] {
+    enum class symbol : std::uint8_t { foo, bar, baz };
+
+    "equal atoms have equal hashes"_test = [] {
+        const auto h = std::hash<ta::atom>{};
+        expect(h(ta::atom{ symbol::foo }) == h(ta::atom{ symbol::foo }));
+        expect(h(ta::atom{ "foo"s }) == h(ta::atom{ "foo"s }));
+        expect(h(ta::atom{ 1 }) == h(ta::atom{ ta::atom{ 1 } }));
+    };
+
+    "lookup"_test = [] {
+        const auto env = ta::environment(
+            ta::list(ta::cons(symbol::foo, 1), ta::cons(symbol::bar, "bar"s), ta::cons(2, 3)));
+
+        expect(env.size() == 3uz);
+        expect(*env.lookup(symbol::foo) == ta::sexpr{ 1 });
+        expect(*env.lookup(symbol::bar) == ta::sexpr{ "bar"s });
+        expect(*env.lookup(2) == ta::sexpr{ 3 });
+        expect(env.lookup(symbol::baz) == nullptr);
+        expect(env.lookup(0) == nullptr);
+    };
+
+    "earlier bindings shadow later ones like in assoc"_test = [] {
+        const auto alist = ta::list(ta::cons(symbol::foo, 1), ta::cons(symbol::foo, 2));
+        const auto env   = ta::environment(alist);
+
+        expect(*env.lookup(symbol::foo) == std::visit(ta::assoc(symbol::foo), alist).value().cdr());
+    };
+
+    "extended environment shadows its parent"_test = [] {
+        const auto parent =
+            ta::environment(ta::list(ta::cons(symbol::foo, 1), ta::cons(symbol::bar, 2)));
+        const auto child = parent.extend(ta::list(ta::cons(symbol::foo, 3)));
+
+        expect(*child.lookup(symbol::foo) == ta::sexpr{ 3 });
+        expect(*child.lookup(symbol::bar) == ta::sexpr{ 2 });
+        expect(*parent.lookup(symbol::foo) == ta::sexpr{ 1 });
+    };
+
+    "non-list can not be an environment"_test = [] {
+        expect(throws<std::runtime_error>([] { std::ignore = ta::environment(ta::sexpr{ 1 }); }));
+    };
+
+    "eval with environment"_test = [] {
+        const auto env = ta::environment(ta::list(ta::cons(symbol::foo, "foo"s)));
+
+        const auto x = tyvi::this_thread::sync_wait(ta::eval<symbol>(symbol::foo, env));
+        expect(x == ta::sexpr{ "foo"s });
+
+        expect(throws([&] {
+            std::ignore = tyvi::this_thread::sync_wait(ta::eval<symbol>(symbol::bar, env));
+        }));
+    };
+};
+
+} // namespace
+
+int
+main(int argc, const char** argv) {
+    return static_cast<int>(cfg<override>.run(run_cfg{ .argc = argc, .argv = argv }));
+}
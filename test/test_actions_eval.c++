@@ -1,7 +1,17 @@
 #include <boost/ut.hpp> // import boost.ut;
 
+#include <chrono>
+#include <cstddef>
+#include <iterator>
+#include <mutex>
+#include <set>
 #include <string>
+#include <thread>
 #include <variant>
+#include <vector>
+
+#include "pika/init.hpp"
+#include "pika/runtime.hpp"
 
 #include "tyvi/actions_ast.h"
 #include "tyvi/actions_eval.h"
@@ -124,11 +134,92 @@ const suite<"actions_ast"> _ = [] {
         tyvi::this_thread::sync_wait(ta::eval<action>(src, env));
         expect(str == "barbar");
     };
+
+    "sync procedures are called inline"_test = [] {
+        auto calls = 0;
+
+        const auto add = ta::sync_procedure([&](const ta::sexpr& args) -> ta::sexpr {
+            ++calls;
+            auto sum = 0;
+            for (const auto& x : ta::list_view(args)) {
+                sum += ta::atom_get<int>(std::get<ta::atom>(x));
+            }
+            return sum;
+        });
+
+        const auto env = ta::list(ta::cons(action::append, add));
+        const auto src = ta::list(action::append, 1, ta::list(action::append, 2, 3), 4);
+
+        auto snd = ta::eval<action>(src, env);
+        expect(calls == 0) << "evaluation should be lazy";
+
+        const auto x = tyvi::this_thread::sync_wait(std::move(snd));
+        expect(std::get<ta::atom>(x) == ta::atom{ 10 });
+        expect(calls == 2);
+    };
+
+    "sync and async procedures can be mixed"_test = [] {
+        auto str = std::string{};
+
+        const auto env = ta::list(
+            ta::cons(action::append, ta::procedure(make_concatter(str))),
+            ta::cons(action::foobar, ta::sync_procedure([](const ta::sexpr&) -> ta::sexpr {
+                         return "foobar"s;
+                     })));
+
+        const auto src = ta::list(action::append, ta::list(action::foobar));
+
+        tyvi::this_thread::sync_wait(ta::eval<action>(src, env));
+        expect(str == "foobar");
+    };
+
+    "arguments are mapped on the given scheduler"_test = [] {
+        auto m       = std::mutex{};
+        auto threads = std::set<std::thread::id>{};
+
+        const auto record = ta::sync_procedure([&](const ta::sexpr&) -> ta::sexpr {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            const std::scoped_lock _{ m };
+            threads.insert(std::this_thread::get_id());
+            return 1;
+        });
+        const auto count = ta::procedure([](ta::sexpr args) -> ta::sexpr_sender {
+            const auto n = static_cast<int>(std::ranges::distance(ta::list_view(args)));
+            return te::just(ta::sexpr{ n });
+        });
+
+        const auto env = ta::environment(
+            ta::list(ta::cons(action::append, count), ta::cons(action::foobar, record)));
+
+        constexpr auto n = 32;
+        auto elems       = std::vector<ta::sexpr>{ action::append };
+        for (auto i = 0; i < n; ++i) { elems.push_back(ta::list(action::foobar)); }
+        const auto src = ta::list(std::from_range, elems);
+
+        const auto opts = ta::eval_options{
+            .args = { .grain_size = 1, .scheduler = te::thread_pool_scheduler{} }
+        };
+        const auto x = tyvi::this_thread::sync_wait(ta::eval<action>(src, env, opts));
+        expect(std::get<ta::atom>(x) == ta::atom{ n });
+
+        expect(not threads.empty());
+        if (pika::get_num_worker_threads() > 1uz) { expect(threads.size() > 1uz); }
+    };
 };
 
 } // namespace
 
 int
 main(int argc, const char** argv) {
-    return static_cast<int>(cfg<override>.run(run_cfg{ .argc = argc, .argv = argv }));
+    // Runtime is required by thread_pool_scheduler.
+    return pika::init(
+        [&] {
+            const auto x =
+                static_cast<int>(cfg<override>.run(run_cfg{ .argc = argc, .argv = argv }));
+            pika::finalize();
+            return x;
+        },
+        0,
+        nullptr,
+        pika::init_params{});
 }
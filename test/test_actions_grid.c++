@@ -0,0 +1,110 @@
+#include <boost/ut.hpp> // import boost.ut;
+
+#include <cstddef>
+#include <cstdint>
+#include <variant>
+
+#include "pika/init.hpp"
+
+#include "tyvi/actions_ast.h"
+#include "tyvi/actions_eval.h"
+#include "tyvi/actions_grid.h"
+#include "tyvi/actions_list.h"
+#include "tyvi/execution.h"
+#include "tyvi/mdgrid.h"
+#include "tyvi/mdspan.h"
+
+namespace {
+using namespace boost::ut;
+namespace ta = tyvi::actions;
+namespace te = tyvi::exec;
+
+constexpr auto scalar_desc = tyvi::mdgrid_element_descriptor<int>{ .rank = 0, .dim = 3 };
+using scalar_mdg           = tyvi::mdgrid<scalar_desc, std::dextents<std::size_t, 3>>;
+
+enum class op : std::uint8_t { fill_a, fill_b, add, sync_c, join };
+
+auto
+grid_program(scalar_mdg& a, scalar_mdg& b, scalar_mdg& c, const ta::grid_options& opts)
+    -> ta::sexpr {
+    return ta::list(
+        ta::cons(op::fill_a,
+                 ta::grid_for_each_index(
+                     a, [TYVI_CMDS(a)](const auto& idx) { a_mds[idx][] = 1; }, "fill a", opts)),
+        ta::cons(op::fill_b,
+                 ta::grid_for_each_index(
+                     b, [TYVI_CMDS(b)](const auto& idx) { b_mds[idx][] = 2; }, "fill b", opts)),
+        ta::cons(op::add,
+                 ta::grid_for_each_index(
+                     c,
+                     [TYVI_CMDS(a, b, c)](const auto& idx) {
+                         c_mds[idx][] = a_mds[idx][] + b_mds[idx][];
+                     },
+                     "add",
+                     opts)),
+        ta::cons(op::sync_c, ta::grid_sync_to_staging(c, "sync c", opts)),
+        ta::cons(op::join, ta::grid_join()));
+}
+
+[[maybe_unused]]
+const suite<"actions_grid"> _ = [] {
+    "grid procedure returns work token"_test = [] {
+        const auto p   = ta::grid_join();
+        const auto val = tyvi::this_thread::sync_wait(p(ta::null));
+
+        expect(std::holds_alternative<ta::atom>(val));
+        expect(ta::atom_is_of_type<ta::work_token>(std::get<ta::atom>(val)));
+        expect(nothrow([&] { ta::wait_work(val); }));
+    };
+
+    "grid kernels are joined by data dependencies"_test = [] {
+        auto a = scalar_mdg(4, 3, 2);
+        auto b = scalar_mdg(4, 3, 2);
+        auto c = scalar_mdg(4, 3, 2);
+
+        const auto env = grid_program(a, b, c, {});
+        const auto src =
+            ta::list(op::sync_c, ta::list(op::add, ta::list(op::fill_a), ta::list(op::fill_b)));
+
+        const auto val = tyvi::this_thread::sync_wait(ta::eval<op>(src, env));
+        ta::wait_work(val);
+
+        const auto smds = c.staging_mds();
+        for (const auto idx : tyvi::sstd::index_space(smds)) { expect(smds[idx][] == 3); }
+    };
+
+    "independent grid kernels run as separate tasks"_test = [] {
+        auto a = scalar_mdg(4, 3, 2);
+        auto b = scalar_mdg(4, 3, 2);
+        auto c = scalar_mdg(4, 3, 2);
+
+        const auto opts = ta::grid_options{ .scheduler = te::thread_pool_scheduler{} };
+        const auto env  = grid_program(a, b, c, opts);
+        const auto src  = ta::list(
+            op::join,
+            ta::list(op::sync_c, ta::list(op::add, ta::list(op::fill_a), ta::list(op::fill_b))));
+
+        const auto val = tyvi::this_thread::sync_wait(ta::eval<op>(src, env));
+        ta::wait_work(val);
+
+        const auto smds = c.staging_mds();
+        for (const auto idx : tyvi::sstd::index_space(smds)) { expect(smds[idx][] == 3); }
+    };
+};
+
+} // namespace
+
+int
+main(int argc, const char** argv) {
+    // Runtime is required by thread_pool_scheduler.
+    return pika::init(
+        [&] {
+            const auto x =
+                static_cast<int>(cfg<override>.run(run_cfg{ .argc = argc, .argv = argv }));
+            pika::finalize();
+            return x;
+        },
+        0,
+        nullptr,
+        pika::init_params{});
+}
@@ -1,9 +1,12 @@
 #include "constant_testing.h"
 #include <boost/ut.hpp> // import boost.ut;
 
+#include <numeric>
 #include <ranges>
 #include <vector>
 
+#include "pika/init.hpp"
+
 #include "tyvi/actions_ast.h"
 #include "tyvi/actions_list.h"
 #include "tyvi/execution.h"
@@ -95,6 +98,21 @@ const suite<"actions_lists"> _ = [] {
         });
     };
 
+    "C++: list append does not modify its arguments"_test = [] {
+        tyvi::constant_testing([](auto& tester) static consteval {
+            const auto foo = ta::list(1, 2);
+            const auto bar = ta::list(3);
+
+            const auto foobar = std::visit(ta::list_append, foo, bar);
+            tester.expect(foo == ta::list(1, 2));
+            tester.expect(bar == ta::list(3));
+
+            // Tail is shared with the last argument.
+            const auto& tail = std::get<ta::cons>(std::get<ta::cons>(foobar).cdr()).cdr();
+            tester.expect(&std::get<ta::cons>(tail).car() == &std::get<ta::cons>(bar).car());
+        });
+    };
+
     "C++: list_view"_test = [] {
         tyvi::constant_testing([](auto& tester) static consteval {
             tester.expect(std::ranges::empty(ta::list_view(ta::list())));
@@ -154,10 +172,73 @@ const suite<"actions_lists"> _ = [] {
         const auto mapped_empty = tyvi::this_thread::sync_wait(ta::map(x2, ta::list()));
         expect(mapped_empty == ta::list());
     };
+
+    "C++: map with grain size and scheduler"_test = [] {
+        auto plus1 = [](const ta::sexpr& s) -> ta::sexpr_sender {
+            return te::just(ta::atom_get<int>(std::get<ta::atom>(s)) + 1)
+                   | te::then([](const int i) -> ta::sexpr { return i; });
+        };
+
+        auto xs       = std::vector<int>(1000);
+        auto expected = std::vector<int>(1000);
+        std::ranges::iota(xs, 0);
+        std::ranges::iota(expected, 1);
+
+        const auto list = ta::list(std::from_range, xs);
+
+        for (const auto grain_size : { 0uz, 1uz, 7uz, 16uz, 5000uz }) {
+            const auto opts = ta::map_options{ .grain_size = grain_size };
+            const auto x    = tyvi::this_thread::sync_wait(ta::map(plus1, list, opts));
+            expect(x == ta::list(std::from_range, expected));
+        }
+
+        const auto opts =
+            ta::map_options{ .grain_size = 10, .scheduler = te::thread_pool_scheduler{} };
+        const auto x = tyvi::this_thread::sync_wait(ta::map(plus1, list, opts));
+        expect(x == ta::list(std::from_range, expected));
+    };
+
+    "C++: long lists are handled without recursion"_test = [] {
+        // Deep enough to overflow the stack, if any of these recursed per element.
+        constexpr auto n = 500'000;
+
+        auto xs = std::vector<int>(n);
+        std::ranges::iota(xs, 0);
+
+        const auto a = ta::list(std::from_range, xs);
+        const auto b = ta::list(std::from_range, xs);
+        expect(ta::is_list(std::get<ta::cons>(a)));
+        expect(ta::hash_value(a) == ta::hash_value(b));
+        expect(a == b);
+
+        const auto c = ta::sexpr{ ta::cons(-1, a) };
+        expect(c != b);
+        expect(std::ranges::distance(ta::list_view(c)) == n + 1);
+
+        auto plus1 = [](const ta::sexpr& s) -> ta::sexpr_sender {
+            return te::just(ta::atom_get<int>(std::get<ta::atom>(s)) + 1)
+                   | te::then([](const int i) -> ta::sexpr { return i; });
+        };
+        const auto opts =
+            ta::map_options{ .grain_size = 1024, .scheduler = te::thread_pool_scheduler{} };
+        const auto mapped = tyvi::this_thread::sync_wait(ta::map(plus1, a, opts));
+        expect(std::get<ta::atom>(std::get<ta::cons>(mapped).car()) == ta::atom{ 1 });
+        expect(std::ranges::distance(ta::list_view(mapped)) == n);
+    };
 };
 } // namespace
 
 int
 main(int argc, const char** argv) {
-    return static_cast<int>(cfg<override>.run(run_cfg{ .argc = argc, .argv = argv }));
+    // Runtime is required by thread_pool_scheduler.
+    return pika::init(
+        [&] {
+            const auto x =
+                static_cast<int>(cfg<override>.run(run_cfg{ .argc = argc, .argv = argv }));
+            pika::finalize();
+            return x;
+        },
+        0,
+        nullptr,
+        pika::init_params{});
 }
@@ -0,0 +1,96 @@
+#include <boost/ut.hpp> // import boost.ut;
+
+#include <cstdint>
+#include <functional>
+#include <unordered_set>
+#include <utility>
+#include <variant>
+
+#include "tyvi/actions_ast.h"
+#include "tyvi/actions_eval.h"
+#include "tyvi/actions_list.h"
+#include "tyvi/actions_memo.h"
+#include "tyvi/execution.h"
+
+namespace {
+using namespace boost::ut;
+namespace ta = tyvi::actions;
+namespace te = tyvi::exec;
+
+[[maybe_unused]]
+const suite<"actions_memo"> _ = [] {
+    enum class action : std::uint8_t { twice, sum };
+
+    static constexpr auto make_twice = [](int& calls) {
+        return [&calls](ta::sexpr args) -> ta::sexpr_sender {
+            ++calls;
+            return te::just(std::move(args)) | te::then([](const ta::sexpr& s) -> ta::sexpr {
+                       const auto& x = std::get<ta::atom>(std::get<ta::cons>(s).car());
+                       return 2 * ta::atom_get<int>(x);
+                   });
+        };
+    };
+
+    static constexpr auto sum = [](const ta::sexpr& s) -> ta::sexpr {
+        auto n = 0;
+        for (const auto& x : ta::list_view(s)) { n += ta::atom_get<int>(std::get<ta::atom>(x)); }
+        return n;
+    };
+
+    "equal lists have equal hashes"_test = [] {
+        const auto a = ta::list(1, 2, ta::list(3, 4));
+        const auto b = ta::list(1, 2, ta::list(3, 4));
+        const auto c = ta::list(1, 2, ta::list(3, 5));
+
+        expect(ta::hash_value(a) == ta::hash_value(b));
+        expect(ta::hash_value(a) == ta::hash_value(a));
+        expect(a != c);
+
+        const auto set = std::unordered_set<ta::sexpr>{ a, b, c };
+        expect(set.size() == 2uz);
+    };
+
+    "identical subexpressions are evaluated once"_test = [] {
+        auto calls     = 0;
+        const auto env = ta::list(ta::cons(action::twice, ta::procedure(make_twice(calls))),
+                                  ta::cons(action::sum, ta::sync_procedure(sum)));
+        const auto twice_one = ta::list(action::twice, 1);
+        const auto src       = ta::list(action::sum, twice_one, ta::list(action::twice, 1));
+
+        const auto menv = ta::environment(env);
+        const auto memo = ta::memo_table{};
+
+        const auto val = tyvi::this_thread::sync_wait(ta::eval<action>(src, menv, memo));
+        expect(val == ta::sexpr{ 4 });
+        expect(calls == 1);
+        expect(memo.hits() >= 1uz);
+
+        // Entries are shared between evaluations in the same environment.
+        const auto again = tyvi::this_thread::sync_wait(ta::eval<action>(twice_one, menv, memo));
+        expect(again == ta::sexpr{ 2 });
+        expect(calls == 1);
+
+        // but not with other environments.
+        tyvi::this_thread::sync_wait(ta::eval<action>(twice_one, ta::environment(env), memo));
+        expect(calls == 2);
+    };
+
+    "without memo subexpressions are evaluated every time"_test = [] {
+        auto calls     = 0;
+        const auto env = ta::list(ta::cons(action::twice, ta::procedure(make_twice(calls))),
+                                  ta::cons(action::sum, ta::sync_procedure(sum)));
+        const auto src =
+            ta::list(action::sum, ta::list(action::twice, 1), ta::list(action::twice, 1));
+
+        const auto val = tyvi::this_thread::sync_wait(ta::eval<action>(src, env));
+        expect(val == ta::sexpr{ 4 });
+        expect(calls == 2);
+    };
+};
+
+} // namespace
+
+int
+main(int argc, const char** argv) {
+    return static_cast<int>(cfg<override>.run(run_cfg{ .argc = argc, .argv = argv }));
+}
@@ -0,0 +1,112 @@
+#include <boost/ut.hpp> // import boost.ut;
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <variant>
+
+#include "pika/init.hpp"
+
+#include "tyvi/actions_ast.h"
+#include "tyvi/actions_eval.h"
+#include "tyvi/actions_list.h"
+#include "tyvi/actions_schedule.h"
+#include "tyvi/execution.h"
+
+namespace {
+using namespace boost::ut;
+namespace ta = tyvi::actions;
+namespace te = tyvi::exec;
+
+[[maybe_unused]]
+const suite<"actions_schedule"> _ = [] {
+    enum class action : std::uint8_t { slow, fast, sum };
+
+    static constexpr auto sum = [](ta::sexpr args) -> ta::sexpr_sender {
+        return te::just(std::move(args)) | te::then([](const ta::sexpr& s) -> ta::sexpr {
+                   auto n = 0;
+                   for (const auto& x : ta::list_view(s)) {
+                       n += ta::atom_get<int>(std::get<ta::atom>(x));
+                   }
+                   return n;
+               });
+    };
+
+    "critical path is the longest chain of calls"_test = [] {
+        const auto costs = ta::cost_model{};
+        costs.hint(action::slow, 2.0);
+        costs.hint(action::fast, 1.0);
+
+        const auto src = ta::list(action::slow,
+                                  ta::list(action::fast),
+                                  ta::list(action::slow, ta::list(action::fast)),
+                                  ta::list(ta::intrinsic::quote, ta::list(action::slow)));
+
+        expect(ta::critical_path(src, costs) == 5.0_d);
+        expect(ta::critical_path(ta::list(action::sum), costs) == 0.0_d);
+        expect(ta::critical_path(ta::sexpr{ 42 }, costs) == 0.0_d);
+    };
+
+    "measured cost overrides hint"_test = [] {
+        const auto costs = ta::cost_model{};
+        expect(costs.cost(action::slow) == ta::cost_model::default_cost);
+
+        costs.hint(action::slow, 2.0);
+        expect(costs.cost(action::slow) == 2.0_d);
+
+        costs.record(action::slow, 4.0);
+        expect(costs.cost(action::slow) == 4.0_d);
+
+        costs.record(action::slow, 8.0);
+        expect(costs.cost(action::slow) == 5.0_d);
+    };
+
+    "scheduled eval gives the same value and records calls"_test = [] {
+        const auto env = ta::list(ta::cons(action::sum, ta::procedure(sum)));
+        const auto src = ta::list(action::sum,
+                                  1,
+                                  ta::list(action::sum, 2, 3),
+                                  ta::list(action::sum, ta::list(action::sum, 4), 5));
+
+        const auto costs = ta::cost_model{};
+        costs.hint(action::sum, 1.0);
+        const auto sched = ta::critical_path_scheduler(costs);
+
+        const auto opts = ta::eval_options{ .scheduler = sched };
+        const auto val =
+            tyvi::this_thread::sync_wait(ta::eval<action>(src, ta::environment(env), opts));
+        expect(val == ta::sexpr{ 15 });
+        expect(val == tyvi::this_thread::sync_wait(ta::eval<action>(src, env)));
+
+        const auto records = sched.records();
+        expect(records.size() == 4uz);
+        expect(std::ranges::is_sorted(records, {}, &ta::schedule_record::start));
+        expect(std::ranges::all_of(records, [](const ta::schedule_record& r) {
+            return r.start <= r.end and r.symbol == ta::sexpr{ action::sum };
+        }));
+
+        // Outermost call has the longest critical path and it finishes last.
+        const auto outer = std::ranges::max_element(records, {}, &ta::schedule_record::end);
+        expect(outer->critical_path == 3.0_d);
+
+        // Durations were measured, so hint is not used anymore.
+        expect(costs.cost(action::sum) != 1.0_d);
+    };
+};
+
+} // namespace
+
+int
+main(int argc, const char** argv) {
+    // Runtime is required by thread_pool_scheduler.
+    return pika::init(
+        [&] {
+            const auto x =
+                static_cast<int>(cfg<override>.run(run_cfg{ .argc = argc, .argv = argv }));
+            pika::finalize();
+            return x;
+        },
+        0,
+        nullptr,
+        pika::init_params{});
+}
@@ -0,0 +1,112 @@
+#include <boost/ut.hpp> // import boost.ut;
+
+#include <algorithm>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <variant>
+
+#include "tyvi/actions_ast.h"
+#include "tyvi/actions_eval.h"
+#include "tyvi/actions_list.h"
+#include "tyvi/actions_trace.h"
+#include "tyvi/execution.h"
+#include "tyvi/instrumentation.h"
+
+namespace {
+using namespace boost::ut;
+namespace ta  = tyvi::actions;
+namespace te  = tyvi::exec;
+namespace tin = tyvi::instrumentation;
+
+[[maybe_unused]]
+const suite<"actions_trace"> _ = [] {
+    enum class action : std::uint8_t { sum, twice };
+
+    static constexpr auto sum = [](ta::sexpr args) -> ta::sexpr_sender {
+        return te::just(std::move(args)) | te::then([](const ta::sexpr& s) -> ta::sexpr {
+                   auto n = 0;
+                   for (const auto& x : ta::list_view(s)) {
+                       n += ta::atom_get<int>(std::get<ta::atom>(x));
+                   }
+                   return n;
+               });
+    };
+
+    static constexpr auto twice = [](ta::sexpr args) -> ta::sexpr_sender {
+        return te::just(std::move(args)) | te::then([](const ta::sexpr& s) -> ta::sexpr {
+                   return 2 * ta::atom_get<int>(std::get<ta::atom>(std::get<ta::cons>(s).car()));
+               });
+    };
+
+    static constexpr auto name = [](const ta::atom& a) -> std::string {
+        switch (ta::atom_get<action>(a)) {
+            case action::sum: return "sum";
+            case action::twice: return "twice";
+        }
+        return {};
+    };
+
+    "procedure calls are recorded"_test = [] {
+        const auto env = ta::list(ta::cons(action::sum, ta::procedure(sum)),
+                                  ta::cons(action::twice, ta::procedure(twice)));
+        const auto src = ta::list(action::sum,
+                                  ta::list(action::twice, 1),
+                                  ta::list(action::twice, 2),
+                                  ta::list(action::sum, 3, ta::list(action::twice, 4)));
+
+        const auto tracer = ta::eval_tracer(name);
+        const auto opts   = ta::eval_options{ .tracer = tracer };
+        const auto val =
+            tyvi::this_thread::sync_wait(ta::eval<action>(src, ta::environment(env), opts));
+        expect(val == ta::sexpr{ 17 });
+
+        const auto records = tracer.records();
+
+        if constexpr (not tin::enabled) {
+            expect(records.empty());
+            return;
+        }
+
+        expect(records.size() == 5uz);
+        expect(std::ranges::all_of(records, [](const ta::call_record& r) {
+            return r.args_start <= r.call_start and r.call_start <= r.end;
+        }));
+
+        // Outermost call waits for all the other calls.
+        const auto outer = std::ranges::max_element(records, {}, &ta::call_record::end);
+        expect(outer->symbol == ta::sexpr{ action::sum });
+        expect(std::ranges::all_of(records, [&](const ta::call_record& r) {
+            return outer->args_start <= r.args_start;
+        }));
+
+        const auto profile = tracer.profile();
+        expect(profile.size() == 2uz);
+
+        const auto find = [&](const action a) {
+            return std::ranges::find(profile, ta::sexpr{ a }, &ta::symbol_profile::symbol);
+        };
+        expect(find(action::sum)->calls == 2uz);
+        expect(find(action::twice)->calls == 3uz);
+        for (const auto& p : profile) {
+            expect(p.max_concurrency >= 1uz);
+            expect(p.mean_concurrency >= 1.0);
+        }
+
+        auto ss = std::stringstream{};
+        tracer.write_chrome_trace(ss);
+        expect(ss.str().contains(R"("name":"twice")"));
+        expect(ss.str().contains(R"("name":"sum")"));
+
+        tracer.clear();
+        expect(tracer.records().empty());
+    };
+};
+
+} // namespace
+
+int
+main(int argc, const char** argv) {
+    return static_cast<int>(cfg<override>.run(run_cfg{ .argc = argc, .argv = argv }));
+}
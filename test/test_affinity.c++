@@ -0,0 +1,165 @@
+#include <boost/ut.hpp> // import boost.ut;
+
+#include <cstddef>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "pika/init.hpp"
+#include "pika/runtime.hpp"
+
+#include "tyvi/affinity.h"
+#include "tyvi/numa.h"
+
+namespace {
+using namespace boost::ut;
+namespace taf = tyvi::affinity;
+
+const auto two_nodes = std::vector<tyvi::numa::node>{ { .id = 0, .cpus = { 0, 1, 2 } },
+                                                      { .id = 1, .cpus = { 4, 5 } } };
+
+void
+clear_env() {
+    ::unsetenv("TYVI_NUM_THREADS");
+    ::unsetenv("TYVI_BIND");
+    ::unsetenv("TYVI_NUMA_POLICY");
+}
+
+[[maybe_unused]]
+const suite<"affinity"> _ = [] {
+    "cpu lists are parsed and formatted"_test = [] {
+        const auto cpus = tyvi::numa::parse_cpulist("0-2,4,6-7\n");
+        expect(cpus == std::vector<std::size_t>{ 0, 1, 2, 4, 6, 7 });
+        expect(tyvi::numa::format_cpulist(cpus) == "0-2,4,6-7");
+
+        expect(tyvi::numa::parse_cpulist("").empty());
+        expect(tyvi::numa::parse_cpulist("3-1").empty());
+        expect(tyvi::numa::parse_cpulist("0,,1").empty());
+    };
+
+    "compact binding fills nodes in order"_test = [] {
+        const auto cfg = taf::config{ .num_threads = 7, .bind = taf::binding::compact };
+        expect(taf::plan(cfg, two_nodes) == std::vector<std::size_t>{ 0, 1, 2, 4, 5, 0, 1 });
+    };
+
+    "scatter binding alternates between nodes"_test = [] {
+        const auto cfg = taf::config{ .bind = taf::binding::scatter };
+        expect(taf::num_threads(cfg, two_nodes) == 5uz);
+        expect(taf::plan(cfg, two_nodes) == std::vector<std::size_t>{ 0, 4, 1, 5, 2 });
+    };
+
+    "list binding cycles the listed cpus"_test = [] {
+        const auto cfg =
+            taf::config{ .num_threads = 3, .bind = taf::binding::list, .cpus = { 5, 1 } };
+        expect(taf::plan(cfg, two_nodes) == std::vector<std::size_t>{ 5, 1, 5 });
+
+        expect(throws([] { std::ignore = taf::plan({ .bind = taf::binding::list }); }));
+    };
+
+    "unbound threads have no plan"_test = [] {
+        expect(taf::plan({ .num_threads = 4 }, two_nodes).empty());
+    };
+
+    "config is read from environment"_test = [] {
+        clear_env();
+        ::setenv("TYVI_NUM_THREADS", "6", 1);
+        ::setenv("TYVI_BIND", "0-1,4", 1);
+        ::setenv("TYVI_NUMA_POLICY", "interleave", 1);
+
+        const auto cfg = taf::config_from_env();
+        expect(cfg.num_threads == 6uz);
+        expect(cfg.bind == taf::binding::list);
+        expect(cfg.cpus == std::vector<std::size_t>{ 0, 1, 4 });
+        expect(cfg.numa == taf::numa_policy::interleave);
+
+        ::setenv("TYVI_BIND", "scatter", 1);
+        ::unsetenv("TYVI_NUM_THREADS");
+        const auto scattered = taf::config_from_env({ .num_threads = 2 });
+        expect(scattered.num_threads == 2uz);
+        expect(scattered.bind == taf::binding::scatter);
+
+        clear_env();
+    };
+
+    "invalid environment throws"_test = [] {
+        clear_env();
+        ::setenv("TYVI_NUM_THREADS", "many", 1);
+        expect(throws([] { std::ignore = taf::config_from_env(); }));
+
+        clear_env();
+        ::setenv("TYVI_BIND", "everywhere", 1);
+        expect(throws([] { std::ignore = taf::config_from_env(); }));
+
+        clear_env();
+        ::setenv("TYVI_NUMA_POLICY", "remote", 1);
+        expect(throws([] { std::ignore = taf::config_from_env(); }));
+
+        clear_env();
+    };
+
+    "default config leaves pika untouched"_test = [] {
+        auto params = pika::init_params{};
+        taf::configure_pika({}, params);
+        expect(params.cfg.empty());
+    };
+
+    "pika is given thread count and binding"_test = [] {
+        const auto& nodes = tyvi::numa::nodes();
+        const auto cpu    = nodes.front().cpus.front();
+        const auto cfg =
+            taf::config{ .num_threads = 2, .bind = taf::binding::list, .cpus = { cpu } };
+
+        auto params = pika::init_params{};
+        taf::configure_pika(cfg, params);
+
+        const auto pu = std::to_string(cpu);
+        expect(params.cfg.size() == 2uz);
+        expect(params.cfg[0] == "pika.os_threads=2");
+        expect(params.cfg[1] == "pika.bind=thread:0=pu:" + pu + ";thread:1=pu:" + pu);
+    };
+
+    "report lists pinning of each thread"_test = [] {
+        const auto cpu = tyvi::numa::nodes().front().cpus.front();
+        const auto cfg =
+            taf::config{ .num_threads = 2, .bind = taf::binding::list, .cpus = { cpu } };
+
+        auto os = std::ostringstream{};
+        taf::write_report(os, cfg);
+        const auto report = os.str();
+
+        expect(report.contains("threads=2 bind=list"));
+        expect(report.contains("thread 1 -> cpu " + std::to_string(cpu)));
+        expect(report.contains("calling thread runs on cpus"));
+    };
+
+    "worker report lists each pika worker"_test = [] {
+        expect(taf::worker_cpus().size() == pika::get_num_worker_threads());
+
+        auto os = std::ostringstream{};
+        taf::write_worker_report(os);
+        expect(os.str().contains("tyvi affinity: worker 0 runs on cpus"));
+    };
+
+    "inherited memory policy is always supported"_test = [] {
+        expect(taf::set_memory_policy(taf::numa_policy::inherit));
+    };
+};
+
+} // namespace
+
+int
+main(int argc, const char** argv) {
+    // Runtime is required by worker_cpus.
+    return pika::init(
+        [&] {
+            const auto x =
+                static_cast<int>(cfg<override>.run(run_cfg{ .argc = argc, .argv = argv }));
+            pika::finalize();
+            return x;
+        },
+        0,
+        nullptr,
+        pika::init_params{});
+}
@@ -0,0 +1,89 @@
+#include <boost/ut.hpp> // import boost.ut;
+
+#include <algorithm>
+#include <cstddef>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "tyvi/backend.h"
+#include "tyvi/huge_pages.h"
+#include "tyvi/mdgrid.h"
+
+namespace {
+using namespace boost::ut;
+namespace thp = tyvi::huge_pages;
+
+template<typename T>
+using huge_vector = std::vector<T, thp::allocator<T>>;
+
+[[maybe_unused]]
+const suite<"huge_pages"> _ = [] {
+    "huge pages are disabled by default"_test = [] {
+        expect(not thp::threshold().has_value());
+
+        const auto v = huge_vector<double>(thp::page_size);
+        expect(thp::regions().empty());
+    };
+
+    "large allocations are aligned huge page regions"_test = [] {
+        thp::set_threshold(thp::page_size);
+
+        {
+            const auto small = huge_vector<char>(thp::page_size / 2uz);
+            expect(thp::regions().empty());
+
+            auto large = huge_vector<double>(thp::page_size / 4uz);
+            std::ranges::fill(large, 1.0);
+
+            const auto r = thp::regions();
+            expect(r.size() == 1uz);
+            expect(r[0].address % thp::page_size == 0uz);
+            expect(r[0].bytes == 2uz * thp::page_size);
+
+            // Pages are only backed by huge pages if the system allows it.
+            if (const auto backed = thp::backed_bytes(r[0])) { expect(*backed <= r[0].bytes); }
+        }
+
+        expect(thp::regions().empty());
+        thp::set_threshold({});
+    };
+
+    "grids use huge pages on cpu backend"_test = [] {
+        if constexpr (tyvi::active_backend != tyvi::backend::cpu) { return; }
+
+        constexpr auto elem_desc = tyvi::mdgrid_element_descriptor<float>{ .rank = 1, .dim = 3 };
+        using mdg                = tyvi::mdgrid<elem_desc, std::dextents<std::size_t, 3>>;
+
+        thp::set_threshold(thp::page_size);
+        {
+            // Both device and staging buffers are 3 MiB.
+            const auto grid = mdg(64, 64, 64);
+            expect(thp::regions().size() == 2uz);
+        }
+        expect(thp::regions().empty());
+        thp::set_threshold({});
+    };
+
+    "report lists the regions"_test = [] {
+        thp::set_threshold(thp::page_size);
+        const auto v = huge_vector<char>(thp::page_size);
+
+        auto ss = std::stringstream{};
+        thp::write_report(ss);
+        const auto report = ss.str();
+
+        expect(report.starts_with("transparent huge pages:"));
+        expect(report.contains("advised"));
+        expect(report.contains("2.00"));
+
+        thp::set_threshold({});
+    };
+};
+
+} // namespace
+
+int
+main(int argc, const char** argv) {
+    return static_cast<int>(cfg<override>.run(run_cfg{ .argc = argc, .argv = argv }));
+}
@@ -0,0 +1,138 @@
+#include <boost/ut.hpp> // import boost.ut;
+
+#include <algorithm>
+#include <cstddef>
+#include <sstream>
+#include <string>
+
+#include "tyvi/instrumentation.h"
+#include "tyvi/mdgrid.h"
+
+namespace {
+using namespace boost::ut;
+namespace tin = tyvi::instrumentation;
+
+[[maybe_unused]]
+const suite<"instrumentation"> _ = [] {
+    "mdgrid_work operations are recorded"_test = [] {
+        constexpr auto elem_desc = tyvi::mdgrid_element_descriptor<float>{ .rank = 1, .dim = 3 };
+        using mdg                = tyvi::mdgrid<elem_desc, std::dextents<std::size_t, 3>>;
+
+        auto grid = mdg(4, 5, 6);
+
+        tin::clear();
+
+        const auto w = tyvi::mdgrid_work{};
+        w.sync_from_staging(grid, "upload")
+            .for_each(grid, [](const auto& M) { M[0] = 1; }, "init")
+            .for_each_index(grid, [](const auto&) {})
+            .sync_to_staging(grid)
+            .wait();
+
+        const auto records = tin::records();
+
+        if constexpr (not tin::enabled) {
+            expect(records.empty());
+            return;
+        }
+
+        expect(records.size() == 4uz);
+
+        const auto grid_bytes = 4uz * 5uz * 6uz * 3uz * sizeof(float);
+        for (const auto& r : records) {
+            expect(r.bytes == grid_bytes);
+            expect(r.start <= r.end);
+        }
+
+        expect(records[0].label == "upload");
+        expect(records[0].op == tin::operation::sync_from_staging);
+        expect(records[1].label == "init");
+        expect(records[1].op == tin::operation::for_each);
+        expect(records[2].label == "for_each_index");
+        expect(records[3].label == "sync_to_staging");
+
+        const auto is_ordered = std::ranges::is_sorted(records, {}, &tin::kernel_record::start);
+        expect(is_ordered);
+    };
+
+    "when_all is recorded"_test = [] {
+        tin::clear();
+
+        const auto w1       = tyvi::mdgrid_work{};
+        const auto [w2, w3] = w1.split<2>();
+        tyvi::when_all(w2, w3);
+        w1.wait();
+
+        const auto records = tin::records();
+        if constexpr (tin::enabled) {
+            // split also uses when_all.
+            expect(records.size() == 2uz);
+            expect(std::ranges::all_of(records, [](const tin::kernel_record& r) {
+                return r.op == tin::operation::when_all and r.bytes == 0uz;
+            }));
+        } else {
+            expect(records.empty());
+        }
+    };
+
+    "when_all is labelled and records are bounded"_test = [] {
+        tin::clear();
+
+        const auto w1 = tyvi::mdgrid_work{};
+        const auto w2 = tyvi::mdgrid_work{};
+        tyvi::when_all("join", w1, w2);
+
+        const auto labelled = tin::records();
+        if constexpr (tin::enabled) {
+            expect(labelled.size() == 1uz);
+            expect(labelled.front().label == "join");
+        } else {
+            expect(labelled.empty());
+        }
+
+        tin::set_max_records(2);
+        for (auto i = 0; i < 3; ++i) { tyvi::when_all(w1, w2); }
+        w1.wait();
+
+        const auto bounded = tin::records();
+        tin::set_max_records(tin::default_max_records);
+        if constexpr (tin::enabled) {
+            expect(bounded.size() == 2uz);
+            expect(std::ranges::all_of(bounded, [](const tin::kernel_record& r) {
+                return r.label == "when_all";
+            }));
+        } else {
+            expect(bounded.empty());
+        }
+    };
+
+    "chrome trace export"_test = [] {
+        constexpr auto elem_desc = tyvi::mdgrid_element_descriptor<int>{ .rank = 0, .dim = 3 };
+        using mdg                = tyvi::mdgrid<elem_desc, std::dextents<std::size_t, 2>>;
+
+        auto grid = mdg(3, 3);
+
+        tin::clear();
+        tyvi::mdgrid_work{}.for_each(grid, [](const auto& M) { M[] = 2; }, "kernel \"A\"").wait();
+
+        auto ss = std::stringstream{};
+        tin::write_chrome_trace(ss);
+        const auto trace = ss.str();
+
+        expect(trace.starts_with(R"({"displayTimeUnit":"ns","traceEvents":[)"));
+        expect(trace.ends_with("]}\n"));
+
+        if constexpr (tin::enabled) {
+            expect(trace.contains(R"("name":"kernel \"A\"")"));
+            expect(trace.contains(R"("cat":"for_each")"));
+            expect(trace.contains(R"("ph":"X")"));
+        }
+    };
+};
+
+} // namespace
+
+int
+main(int argc, const char** argv) {
+    return static_cast<int>(cfg<override>.run(run_cfg{ .argc = argc, .argv = argv }));
+}
@@ -1,11 +1,18 @@
 #include <boost/ut.hpp> // import boost.ut;
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstddef>
+#include <stdexcept>
 #include <tuple>
 #include <utility>
 
 #include <experimental/mdspan>
 
+#include "pika/init.hpp"
+#include "pika/thread.hpp"
+
 #include "tyvi/mdgrid.h"
 #include "tyvi/mdspan.h"
 
@@ -306,6 +313,11 @@ const suite<"mdgrid"> _ = [] {
         expect(gridA.underlying_buffer() != gridB.underlying_buffer());
         gridB.set_underlying_buffer(gridA.underlying_buffer());
         expect(gridA.underlying_buffer() == gridB.underlying_buffer());
+
+        expect(throws<std::invalid_argument>(
+            [&] { gridB.set_underlying_buffer(mdg::device_vec(3)); }));
+        expect(throws<std::invalid_argument>(
+            [&] { gridB.set_underlying_staging_buffer(mdg::staging_vec(3)); }));
     };
 
     "mdgrid invalidating_resize"_test = [] {
@@ -323,11 +335,103 @@ const suite<"mdgrid"> _ = [] {
         expect(grid.mds().extents() == e);
         expect(grid.staging_mds().extents() == e);
     };
+
+    "chunked sync to staging delivers slabs in order"_test = [] {
+        constexpr auto elem_desc = tyvi::mdgrid_element_descriptor<int>{ .rank = 1, .dim = 3 };
+        using mdg                = tyvi::mdgrid<elem_desc, std::dextents<std::size_t, 3>>;
+
+        auto grid = mdg(5, 4, 3);
+
+        const auto w = tyvi::mdgrid_work{};
+        w.for_each_index(grid, [TYVI_CMDS(grid)](const auto& idx, const auto& jdx) {
+            grid_mds[idx][jdx] = static_cast<int>(jdx[0] * 100 + idx[0]);
+        });
+
+        auto next_offset = 0uz;
+        auto sum         = 0;
+        w.sync_to_staging_chunked(grid, 7, [&](const auto& slab) {
+            expect(slab.offset == next_offset);
+            expect(not slab.data.empty());
+            next_offset += slab.data.size();
+            for (const auto x : slab.data) { sum += x; }
+        });
+        w.wait();
+
+        expect(next_offset == grid.staging_span().size());
+
+        auto expected = 0;
+        const auto smds = grid.staging_mds();
+        for (const auto idx : tyvi::sstd::index_space(smds)) {
+            for (const auto jdx : tyvi::sstd::index_space(smds[idx])) {
+                expect(smds[idx][jdx] == static_cast<int>(jdx[0] * 100 + idx[0]));
+                expected += smds[idx][jdx];
+            }
+        }
+        expect(sum == expected);
+    };
+
+    "chunked sync to staging propagates exceptions"_test = [] {
+        constexpr auto elem_desc = tyvi::mdgrid_element_descriptor<int>{ .rank = 0, .dim = 3 };
+        using mdg                = tyvi::mdgrid<elem_desc, std::dextents<std::size_t, 3>>;
+
+        auto grid = mdg(4, 4, 4);
+
+        const auto w = tyvi::mdgrid_work{};
+        auto calls   = 0uz;
+        expect(throws<std::runtime_error>([&] {
+            w.sync_to_staging_chunked(grid, 4, [&](const auto&) {
+                ++calls;
+                throw std::runtime_error{ "slab" };
+            });
+        }));
+        expect(calls == 1uz);
+    };
+
+    "chunked sync to staging copies the next slab during on_slab"_test = [] {
+        constexpr auto elem_desc = tyvi::mdgrid_element_descriptor<int>{ .rank = 1, .dim = 1 };
+        using mdg                = tyvi::mdgrid<elem_desc, std::dextents<std::size_t, 3>>;
+
+        auto grid = mdg(16, 16, 16);
+
+        const auto w = tyvi::mdgrid_work{};
+        w.for_each_index(grid, [TYVI_CMDS(grid)](const auto& idx, const auto& jdx) {
+            grid_mds[idx][jdx] = 1;
+        });
+
+        const auto staging = grid.staging_span();
+        std::ranges::fill(staging, 0);
+
+        auto next_copied = false;
+        w.sync_to_staging_chunked(grid, 2, [&](const auto& slab) {
+            if (slab.index != 0uz) { return; }
+
+            // Last element belongs to slab 1, which should arrive without returning from here.
+            const auto last     = std::atomic_ref(staging.back());
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+            while (not next_copied and std::chrono::steady_clock::now() < deadline) {
+                next_copied = last.load() == 1;
+                pika::this_thread::yield();
+            }
+        });
+        w.wait();
+
+        expect(next_copied);
+    };
 };
 
 } // namespace
 
 int
 main(int argc, const char** argv) {
-    return static_cast<int>(cfg<override>.run(run_cfg{ .argc = argc, .argv = argv }));
+    // Runtime is required by sync_to_staging_chunked.
+    return pika::init(
+        [&] {
+            const auto x =
+                static_cast<int>(cfg<override>.run(run_cfg{ .argc = argc, .argv = argv }));
+            pika::finalize();
+            return x;
+        },
+        0,
+        nullptr,
+        pika::init_params{});
 }
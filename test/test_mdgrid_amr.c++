@@ -0,0 +1,176 @@
+#include <boost/ut.hpp> // import boost.ut;
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+
+#include "pika/init.hpp"
+#include "pika/runtime.hpp"
+
+#include "tyvi/backend.h"
+#include "tyvi/mdgrid.h"
+#include "tyvi/mdgrid_amr.h"
+#include "tyvi/mdspan.h"
+#include "tyvi/sstd.h"
+
+namespace {
+using namespace boost::ut;
+
+constexpr auto scalar_desc = tyvi::mdgrid_element_descriptor<double>{ .rank = 0, .dim = 2 };
+using amr                  = tyvi::amr_mdgrid<scalar_desc, 2>;
+
+/// Sets each point of level l to its global x index on the level.
+void
+fill_x(amr& grid, const std::size_t l) {
+    grid.for_each_block(l, [](amr::block& b) {
+        b.work.for_each_index(b.grid, [mds = b.grid.mds(), x0 = b.offset[0]](const auto& idx) {
+            mds[idx][] = static_cast<double>(x0 + idx[0]);
+        });
+    });
+}
+
+/// Tags points of level 0 with global x in [4, 8), when filled with fill_x.
+constexpr auto tag_x = [](const auto& M) { return M[] >= 4.0 and M[] < 8.0; };
+
+[[maybe_unused]]
+const suite<"mdgrid_amr"> _ = [] {
+    "level 0 covers the domain"_test = [] {
+        const auto grid = amr({ 3, 2 }, 4, 3);
+
+        expect(grid.num_levels() == 1uz);
+        expect(grid.level(0).size() == 6uz);
+        expect(grid.level(1).empty());
+        expect(grid.level_extents(0) == std::dextents<std::size_t, 2>(12, 8));
+        expect(grid.level_extents(1) == std::dextents<std::size_t, 2>(24, 16));
+
+        const auto* const b = grid.find(0, { 2, 1 });
+        expect(b != nullptr);
+        expect(b->offset == std::array{ 8uz, 4uz });
+        expect(grid.find(0, { 3, 0 }) == nullptr);
+
+        expect(throws([] { [[maybe_unused]] const auto g = amr({ 1, 1 }, 3, 2); }));
+        expect(throws([] { [[maybe_unused]] const auto g = amr({ 1, 1 }, 4, 0); }));
+    };
+
+    "regrid refines tagged blocks and prolongs them"_test = [] {
+        auto grid = amr({ 3, 2 }, 4, 3);
+        fill_x(grid, 0);
+        grid.wait();
+
+        // Coarse x in [4, 8) is fine x in [8, 16), i.e. fine blocks 2 and 3 in x.
+        grid.regrid(0, tag_x);
+        expect(grid.num_levels() == 2uz);
+        expect(grid.level(1).size() == 8uz);
+        expect(grid.find(1, { 2, 0 }) != nullptr and grid.find(1, { 3, 3 }) != nullptr);
+        expect(grid.find(1, { 1, 0 }) == nullptr and grid.find(1, { 4, 0 }) == nullptr);
+
+        grid.sync_to_staging();
+        grid.wait();
+        for (const auto& b : grid.level(1)) {
+            const auto smds = b.grid.staging_mds();
+            for (const auto idx : tyvi::sstd::index_space(smds)) {
+                expect(smds[idx][] == static_cast<double>((b.offset[0] + idx[0]) / 2uz));
+            }
+        }
+    };
+
+    "average_down restricts fine data and inverts prolong"_test = [] {
+        auto grid = amr({ 3, 2 }, 4, 2);
+        fill_x(grid, 0);
+        grid.regrid(0, tag_x);
+
+        // Prolonged data averages back to the coarse data.
+        grid.average_down(0);
+        grid.sync_to_staging();
+        grid.wait();
+        for (const auto& b : grid.level(0)) {
+            const auto smds = b.grid.staging_mds();
+            for (const auto idx : tyvi::sstd::index_space(smds)) {
+                expect(smds[idx][] == static_cast<double>(b.offset[0] + idx[0]));
+            }
+        }
+
+        // Fine x index X averages to 2x + 0.5 on covered coarse points.
+        fill_x(grid, 1);
+        grid.average_down(0);
+        grid.sync_to_staging();
+        grid.wait();
+        for (const auto& b : grid.level(0)) {
+            const auto smds    = b.grid.staging_mds();
+            const auto covered = b.coords[0] == 1uz;
+            for (const auto idx : tyvi::sstd::index_space(smds)) {
+                const auto x = static_cast<double>(b.offset[0] + idx[0]);
+                expect(smds[idx][] == (covered ? 2.0 * x + 0.5 : x));
+            }
+        }
+    };
+
+    "regrid keeps existing blocks and prunes orphans"_test = [] {
+        auto grid = amr({ 3, 2 }, 4, 3);
+        fill_x(grid, 0);
+        grid.regrid(0, tag_x);
+
+        grid.for_each(1, [](const auto& M) { M[] = -1.0; });
+        grid.regrid(0, tag_x);
+        grid.sync_to_staging();
+        grid.wait();
+        for (const auto& b : grid.level(1)) {
+            const auto smds = b.grid.staging_mds();
+            for (const auto idx : tyvi::sstd::index_space(smds)) { expect(smds[idx][] == -1.0); }
+        }
+
+        // Every point of level 1 is tagged, so each block gets 2 x 2 children.
+        grid.regrid(1, [](const auto&) { return true; });
+        expect(grid.num_levels() == 3uz);
+        expect(grid.level(2).size() == 32uz);
+        expect(throws([&] { grid.regrid(2, [](const auto&) { return true; }); }));
+
+        grid.regrid(0, [](const auto&) { return false; });
+        expect(grid.num_levels() == 1uz);
+        expect(grid.level(2).empty());
+    };
+
+    "blocks of a level are visited concurrently"_test = [] {
+        auto grid = amr({ 4, 4 }, 4, 1);
+
+        auto m       = std::mutex{};
+        auto threads = std::set<std::thread::id>{};
+        grid.for_each_block(0, [&](amr::block&) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            const std::scoped_lock _{ m };
+            threads.insert(std::this_thread::get_id());
+        });
+
+        if (tyvi::active_backend == tyvi::backend::cpu and pika::get_num_worker_threads() > 1uz) {
+            expect(threads.size() > 1uz);
+        }
+        expect(not threads.empty());
+
+        expect(throws<std::runtime_error>([&] {
+            grid.for_each_block(0, [](const amr::block& b) {
+                if (b.coords == amr::coords_type{ 2, 3 }) { throw std::runtime_error{ "block" }; }
+            });
+        }));
+    };
+};
+
+} // namespace
+
+int
+main(int argc, const char** argv) {
+    // Runtime is required by for_each_block.
+    return pika::init(
+        [&] {
+            const auto x =
+                static_cast<int>(cfg<override>.run(run_cfg{ .argc = argc, .argv = argv }));
+            pika::finalize();
+            return x;
+        },
+        0,
+        nullptr,
+        pika::init_params{});
+}
@@ -0,0 +1,85 @@
+#include <boost/ut.hpp> // import boost.ut;
+
+#include <algorithm>
+#include <cstddef>
+#include <set>
+
+#include "tyvi/mdgrid.h"
+#include "tyvi/mdgrid_blocked.h"
+#include "tyvi/mdspan.h"
+#include "tyvi/numa.h"
+
+namespace {
+using namespace boost::ut;
+
+constexpr auto elem_desc = tyvi::mdgrid_element_descriptor<int>{ .rank = 1, .dim = 3 };
+using blocked            = tyvi::blocked_mdgrid<elem_desc, std::dextents<std::size_t, 3>>;
+
+[[maybe_unused]]
+const suite<"mdgrid_blocked"> _ = [] {
+    "numa topology is available"_test = [] {
+        const auto& nodes = tyvi::numa::nodes();
+        expect(not nodes.empty());
+        for (const auto& n : nodes) { expect(not n.cpus.empty()); }
+    };
+
+    "blocks cover the global grid"_test = [] {
+        const auto grid = blocked(std::dextents<std::size_t, 3>(10, 4, 5), 3);
+
+        expect(grid.blocks().size() == 3uz);
+
+        auto begin = 0uz;
+        for (const auto& b : grid.blocks()) {
+            expect(b.offset[0] == begin);
+            expect(b.offset[1] == 0uz and b.offset[2] == 0uz);
+            expect(b.grid.extents().extent(1) == 4uz);
+            expect(b.grid.extents().extent(2) == 5uz);
+            expect(b.node != nullptr);
+            begin += b.grid.extents().extent(0);
+        }
+        expect(begin == 10uz);
+    };
+
+    "number of blocks is clamped to first extent"_test = [] {
+        const auto grid = blocked(std::dextents<std::size_t, 3>(2, 4, 5), 8);
+        expect(grid.blocks().size() == 2uz);
+    };
+
+    "for_each is dispatched to every block"_test = [] {
+        auto grid = blocked(std::dextents<std::size_t, 3>(7, 3, 2), 3);
+
+        grid.for_each_block([](blocked::block& b) {
+            b.work.for_each_index(b.grid, [mds = b.grid.mds(), x0 = b.offset[0]](const auto& idx) {
+                mds[idx][0] = static_cast<int>(x0 + idx[0]);
+                mds[idx][1] = 0;
+                mds[idx][2] = 0;
+            });
+        });
+        grid.for_each([](const auto& M) { M[1] = M[0] * 2; });
+        grid.sync_to_staging();
+        grid.wait();
+
+        auto seen = std::set<int>{};
+        for (const auto& b : grid.blocks()) {
+            const auto smds = b.grid.staging_mds();
+            for (const auto idx : tyvi::sstd::index_space(smds)) {
+                expect(smds[idx][1] == 2 * smds[idx][0]);
+                seen.insert(smds[idx][0]);
+            }
+        }
+        expect(seen.size() == 7uz);
+        expect(*seen.begin() == 0 and *seen.rbegin() == 6);
+    };
+
+    "exceptions of blocks are propagated"_test = [] {
+        auto grid = blocked(std::dextents<std::size_t, 3>(4, 1, 1), 2);
+        expect(throws([&] { grid.for_each_block([](auto&) { throw 42; }); }));
+    };
+};
+
+} // namespace
+
+int
+main(int argc, const char** argv) {
+    return static_cast<int>(cfg<override>.run(run_cfg{ .argc = argc, .argv = argv }));
+}
@@ -0,0 +1,81 @@
+#include <boost/ut.hpp> // import boost.ut;
+
+#include <cstddef>
+
+#include "tyvi/mdgrid.h"
+#include "tyvi/mdgrid_ring.h"
+#include "tyvi/mdspan.h"
+#include "tyvi/sstd.h"
+
+namespace {
+using namespace boost::ut;
+
+constexpr auto scalar_desc = tyvi::mdgrid_element_descriptor<int>{ .rank = 0, .dim = 3 };
+using extents              = std::dextents<std::size_t, 3>;
+
+[[maybe_unused]]
+const suite<"mdgrid_ring"> _ = [] {
+    "advance rotates roles without moving buffers"_test = [] {
+        auto ring = tyvi::mdgrid_ring<scalar_desc, extents, 3>(2, 3, 4);
+
+        const auto* const a = ring.current().span().data();
+        const auto* const b = ring.previous(2).span().data();
+        const auto* const c = ring.previous().span().data();
+
+        ring.advance();
+        expect(ring.current().span().data() == b);
+        expect(ring.previous().span().data() == a);
+        expect(ring.previous(2).span().data() == c);
+
+        ring.advance();
+        ring.advance();
+        expect(ring.current().span().data() == a);
+        expect(ring.previous(0).span().data() == a);
+
+        for (const auto& g : ring.grids()) { expect(g.extents() == extents(2, 3, 4)); }
+    };
+
+    "time steps with double_mdgrid and mdgrid_work"_test = [] {
+        auto u = tyvi::double_mdgrid<scalar_desc, extents>(4, 5, 6);
+
+        {
+            const auto smds = u.current().staging_mds();
+            for (const auto idx : tyvi::sstd::index_space(smds)) {
+                smds[idx][] = static_cast<int>(idx[0]);
+            }
+        }
+
+        const auto w = tyvi::mdgrid_work{};
+        w.sync_from_staging(u.current());
+
+        for (auto step = 0; step < 5; ++step) {
+            u.advance();
+            w.for_each_index(u.current(),
+                             [u_new = u.current().mds(), u_old = u.previous().mds()](
+                                 const auto& idx) { u_new[idx][] = u_old[idx][] + 1; });
+        }
+
+        w.sync_to_staging(u.current()).wait();
+
+        const auto smds = u.current().staging_mds();
+        for (const auto idx : tyvi::sstd::index_space(smds)) {
+            expect(smds[idx][] == static_cast<int>(idx[0]) + 5);
+        }
+    };
+
+    "resize applies to all grids"_test = [] {
+        auto ring = tyvi::mdgrid_ring<scalar_desc, extents, 3>(2, 2, 2);
+        ring.set_name("u");
+        ring.invalidating_resize(extents(3, 3, 3));
+
+        for (const auto& g : ring.grids()) { expect(g.extents() == extents(3, 3, 3)); }
+        expect(ring.grids()[2].name() == "u[2]");
+    };
+};
+
+} // namespace
+
+int
+main(int argc, const char** argv) {
+    return static_cast<int>(cfg<override>.run(run_cfg{ .argc = argc, .argv = argv }));
+}
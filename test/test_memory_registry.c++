@@ -0,0 +1,97 @@
+#include <boost/ut.hpp> // import boost.ut;
+
+#include <algorithm>
+#include <cstddef>
+#include <sstream>
+#include <utility>
+
+#include "tyvi/mdgrid.h"
+#include "tyvi/memory_registry.h"
+
+namespace {
+using namespace boost::ut;
+namespace tmem = tyvi::memory;
+
+constexpr auto elem_desc = tyvi::mdgrid_element_descriptor<float>{ .rank = 1, .dim = 3 };
+using mdg                = tyvi::mdgrid<elem_desc, std::dextents<std::size_t, 3>>;
+
+constexpr auto
+grid_bytes(const std::size_t n) -> std::size_t {
+    return n * 3uz * sizeof(float);
+}
+
+[[maybe_unused]]
+const suite<"memory_registry"> _ = [] {
+    "mdgrid is accounted for its lifetime"_test = [] {
+        const auto before = tmem::current();
+        {
+            const auto grid = mdg(4, 5, 6);
+            const auto now  = tmem::current();
+            expect(now.device_bytes == before.device_bytes + grid_bytes(4 * 5 * 6));
+            expect(now.staging_bytes == before.staging_bytes + grid_bytes(4 * 5 * 6));
+        }
+        const auto after = tmem::current();
+        expect(after.device_bytes == before.device_bytes);
+        expect(after.staging_bytes == before.staging_bytes);
+    };
+
+    "copies and moves are accounted"_test = [] {
+        const auto before = tmem::current();
+
+        auto a       = mdg(2, 2, 2);
+        const auto b = a;
+        expect(tmem::current().total() == before.total() + 4uz * grid_bytes(8));
+
+        const auto c = std::move(a);
+        expect(tmem::current().total() <= before.total() + 4uz * grid_bytes(8));
+    };
+
+    "resize is accounted"_test = [] {
+        const auto before = tmem::current();
+
+        auto grid = mdg(2, 2, 2);
+        grid.invalidating_resize(4, 4, 4);
+        expect(tmem::current().device_bytes == before.device_bytes + grid_bytes(64));
+        expect(tmem::current().staging_bytes == before.staging_bytes + grid_bytes(64));
+    };
+
+    "peak is tracked"_test = [] {
+        tmem::reset_peak();
+        const auto before = tmem::current();
+
+        { [[maybe_unused]] const auto grid = mdg(10, 10, 10); }
+
+        expect(tmem::current().total() == before.total());
+        expect(tmem::peak().total() >= before.total() + 2uz * grid_bytes(1000));
+
+        tmem::reset_peak();
+        expect(tmem::peak().total() == tmem::current().total());
+    };
+
+    "named grids are listed"_test = [] {
+        auto grid = mdg(3, 3, 3);
+        grid.set_name("electric field");
+        expect(grid.name() == "electric field");
+
+        const auto copy = grid;
+        expect(copy.name() == "electric field");
+
+        const auto allocs = tmem::allocations();
+        const auto n      = std::ranges::count_if(allocs, [](const tmem::allocation& a) {
+            return a.name == "electric field" and a.bytes.device_bytes == grid_bytes(27);
+        });
+        expect(n == 2);
+
+        auto ss = std::stringstream{};
+        tmem::write_report(ss);
+        expect(ss.str().contains("electric field"));
+        expect(ss.str().contains("peak"));
+    };
+};
+
+} // namespace
+
+int
+main(int argc, const char** argv) {
+    return static_cast<int>(cfg<override>.run(run_cfg{ .argc = argc, .argv = argv }));
+}
@@ -0,0 +1,101 @@
+#include <boost/ut.hpp> // import boost.ut;
+
+#include <array>
+#include <cstddef>
+
+#include "thrust/host_vector.h"
+
+#include "tyvi/mdgrid.h"
+#include "tyvi/mdspan.h"
+#include "tyvi/particle_binning.h"
+#include "tyvi/particles.h"
+
+namespace {
+using namespace boost::ut;
+
+constexpr auto pos_desc    = tyvi::mdgrid_element_descriptor<double>{ .rank = 1, .dim = 2 };
+constexpr auto scalar_desc = tyvi::mdgrid_element_descriptor<double>{ .rank = 0, .dim = 2 };
+using pos_particles        = tyvi::particles<pos_desc>;
+using grid_type            = tyvi::mdgrid<scalar_desc, std::dextents<std::size_t, 2>>;
+
+/// Cell of a particle with unit sized cells.
+constexpr auto cell_of = [](const auto& M) {
+    return std::array{ static_cast<std::size_t>(M[0]), static_cast<std::size_t>(M[1]) };
+};
+
+[[maybe_unused]]
+const suite<"particle_binning"> _ = [] {
+    "particles are sorted by cell and offsets point to cells"_test = [] {
+        const auto w    = tyvi::mdgrid_work{};
+        const auto grid = grid_type(3, 4);
+
+        // Particle i is in cell (i % 3, (7 * i) % 4), with position offset inside the cell.
+        constexpr auto n = 24uz;
+        auto p           = pos_particles(n);
+        w.for_each_index(p, [m = p.mds()](const auto& idx) {
+            const auto i = idx[0];
+            m[idx][0]    = static_cast<double>(i % 3uz) + 0.5;
+            m[idx][1]    = static_cast<double>((7uz * i) % 4uz) + static_cast<double>(i) / 100.0;
+        });
+
+        auto binner = tyvi::particle_binner{};
+        binner.sort(p, grid, cell_of, w);
+
+        const auto offsets = binner.host_offsets();
+        expect(offsets.size() == 13uz);
+        expect(offsets.front() == 0uz);
+        expect(offsets.back() == n);
+
+        w.sync_to_staging(p).wait();
+        const auto smds    = p.staging_mds();
+        const auto mapping = grid.mds().mapping();
+        for (auto i = 0uz; i < 3uz; ++i) {
+            for (auto j = 0uz; j < 4uz; ++j) {
+                const auto k = mapping(i, j);
+                expect(offsets[k + 1uz] - offsets[k] == 2uz);
+                for (auto q = offsets[k]; q < offsets[k + 1uz]; ++q) {
+                    expect(cell_of(smds[q]) == std::array{ i, j });
+                }
+            }
+        }
+    };
+
+    "sort is stable and scratch is reused"_test = [] {
+        const auto w    = tyvi::mdgrid_work{};
+        const auto grid = grid_type(2, 2);
+
+        auto p = pos_particles(8);
+        w.for_each_index(p, [m = p.mds()](const auto& idx) {
+            const auto i = idx[0];
+            m[idx][0]    = static_cast<double>(i % 2uz);
+            m[idx][1]    = static_cast<double>(i) / 10.0;
+        });
+
+        auto binner = tyvi::particle_binner{};
+        binner.sort(p, grid, cell_of, w);
+        const auto* const perm_data = thrust::raw_pointer_cast(binner.permutation().data());
+        const auto temporary_bytes  = binner.temporary_bytes();
+        binner.sort(p, grid, cell_of, w);
+        expect(thrust::raw_pointer_cast(binner.permutation().data()) == perm_data);
+        expect(binner.temporary_bytes() == temporary_bytes);
+
+        // Second sort of sorted particles is identity.
+        const auto perm = thrust::host_vector<std::size_t>(binner.permutation());
+        for (auto i = 0uz; i < perm.size(); ++i) { expect(perm[i] == i); }
+
+        // Particles within a cell keep their original order.
+        w.sync_to_staging(p).wait();
+        const auto smds = p.staging_mds();
+        for (auto i = 0uz; i < 4uz; ++i) {
+            expect(smds[i][0] == 0.0);
+            expect(smds[i][1] == static_cast<double>(2uz * i) / 10.0);
+        }
+    };
+};
+
+} // namespace
+
+int
+main(int argc, const char** argv) {
+    return static_cast<int>(cfg<override>.run(run_cfg{ .argc = argc, .argv = argv }));
+}
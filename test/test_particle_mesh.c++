@@ -0,0 +1,152 @@
+#include <boost/ut.hpp> // import boost.ut;
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "tyvi/mdgrid.h"
+#include "tyvi/mdspan.h"
+#include "tyvi/particle_binning.h"
+#include "tyvi/particle_mesh.h"
+#include "tyvi/particles.h"
+#include "tyvi/sstd.h"
+
+namespace {
+using namespace boost::ut;
+
+/// Particle is position (x, y) and charge.
+constexpr auto particle_desc = tyvi::mdgrid_element_descriptor<double>{ .rank = 1, .dim = 3 };
+constexpr auto scalar_desc   = tyvi::mdgrid_element_descriptor<double>{ .rank = 0, .dim = 2 };
+constexpr auto vec_desc      = tyvi::mdgrid_element_descriptor<double>{ .rank = 1, .dim = 2 };
+
+using pic_particles = tyvi::particles<particle_desc>;
+using extents       = std::dextents<std::size_t, 2>;
+using scalar_grid   = tyvi::mdgrid<scalar_desc, extents>;
+using vec_grid      = tyvi::mdgrid<vec_desc, extents>;
+
+constexpr auto position_of = [](const auto& M) { return std::array{ M[0], M[1] }; };
+constexpr auto charge_of   = [](const auto& M) { return std::array{ M[2] }; };
+
+/// Deterministic pseudo-random positions in [1, 6) x [1, 4) and charges in [1, 2).
+pic_particles
+make_particles(const std::size_t n, const tyvi::mdgrid_work& w) {
+    auto p = pic_particles(n);
+    w.for_each_index(p, [m = p.mds()](const auto& idx) {
+        const auto i = static_cast<double>(idx[0]);
+        m[idx][0]    = 1.0 + 5.0 * std::fmod(i * 0.618034, 1.0);
+        m[idx][1]    = 1.0 + 3.0 * std::fmod(i * 0.414214, 1.0);
+        m[idx][2]    = 1.0 + std::fmod(i * 0.732051, 1.0);
+    });
+    return p;
+}
+
+/// Serial deposit of charge on host with make_stencil.
+template<tyvi::shape S>
+std::vector<double>
+reference_deposit(pic_particles& p, const std::size_t nx, const std::size_t ny) {
+    auto rho        = std::vector<double>(nx * ny, 0.0);
+    const auto smds = p.staging_mds();
+    for (auto q = 0uz; q < p.size(); ++q) {
+        const auto sx = tyvi::make_stencil<S>(smds[q][0]);
+        const auto sy = tyvi::make_stencil<S>(smds[q][1]);
+        for (auto a = 0uz; a < tyvi::shape_support<S>; ++a) {
+            for (auto b = 0uz; b < tyvi::shape_support<S>; ++b) {
+                const auto i = static_cast<std::size_t>(sx.first) + a;
+                const auto j = static_cast<std::size_t>(sy.first) + b;
+                rho[i * ny + j] += sx.weights[a] * sy.weights[b] * smds[q][2];
+            }
+        }
+    }
+    return rho;
+}
+
+template<tyvi::shape S>
+void
+check_deposit() {
+    const auto w = tyvi::mdgrid_work{};
+    auto p       = make_particles(200, w);
+    auto rho     = scalar_grid(8, 6);
+    w.for_each(rho, [](const auto& M) { M[] = 0.0; });
+
+    auto bins = tyvi::particle_binner{};
+    bins.sort(p, rho, tyvi::floor_cell(position_of), w);
+    tyvi::deposit<S>(rho, p, bins, position_of, charge_of, w);
+
+    w.sync_to_staging(p).sync_to_staging(rho).wait();
+    const auto expected = reference_deposit<S>(p, 8, 6);
+    const auto smds     = rho.staging_mds();
+    for (const auto idx : tyvi::sstd::index_space(smds)) {
+        expect(std::abs(smds[idx][] - expected[idx[0] * 6uz + idx[1]]) < 1e-12);
+    }
+}
+
+[[maybe_unused]]
+const suite<"particle_mesh"> _ = [] {
+    "stencil weights sum to one"_test = [] {
+        for (const auto x : { 0.0, 0.25, 0.5, 2.75, 3.49 }) {
+            const auto n = tyvi::make_stencil<tyvi::shape::nearest>(x);
+            const auto c = tyvi::make_stencil<tyvi::shape::cic>(x);
+            const auto t = tyvi::make_stencil<tyvi::shape::tsc>(x);
+            expect(n.weights[0] == 1.0);
+            expect(std::abs(c.weights[0] + c.weights[1] - 1.0) < 1e-15);
+            expect(std::abs(t.weights[0] + t.weights[1] + t.weights[2] - 1.0) < 1e-15);
+        }
+
+        const auto c = tyvi::make_stencil<tyvi::shape::cic>(2.25);
+        expect(c.first == 2);
+        expect(c.weights[0] == 0.75 and c.weights[1] == 0.25);
+
+        const auto t = tyvi::make_stencil<tyvi::shape::tsc>(3.0);
+        expect(t.first == 2);
+        expect(t.weights[0] == 0.125 and t.weights[1] == 0.75 and t.weights[2] == 0.125);
+    };
+
+    "coloured deposit matches serial deposit"_test = [] {
+        check_deposit<tyvi::shape::nearest>();
+        check_deposit<tyvi::shape::cic>();
+        check_deposit<tyvi::shape::tsc>();
+    };
+
+    "deposit requires binned particles"_test = [] {
+        const auto w    = tyvi::mdgrid_work{};
+        auto p          = make_particles(4, w);
+        auto rho        = scalar_grid(8, 6);
+        const auto bins = tyvi::particle_binner{};
+        expect(throws([&] {
+            tyvi::deposit<tyvi::shape::cic>(rho, p, bins, position_of, charge_of, w);
+        }));
+    };
+
+    "gather interpolates linear vector field exactly"_test = [] {
+        const auto w = tyvi::mdgrid_work{};
+        auto p       = make_particles(50, w);
+
+        // Field at grid point (i, j) is (i, 2i + 3j).
+        auto E = vec_grid(8, 6);
+        w.for_each_index(E, [m = E.mds()](const auto& idx) {
+            m[idx][0] = static_cast<double>(idx[0]);
+            m[idx][1] = static_cast<double>(2uz * idx[0] + 3uz * idx[1]);
+        });
+
+        // Store interpolated field into position and charge for checking.
+        const auto store = [](const auto& M, const auto& e) {
+            M[2] = e[1] - (2.0 * M[0] + 3.0 * M[1]);
+            M[0] = e[0] - M[0];
+        };
+        tyvi::gather<tyvi::shape::tsc>(E, p, position_of, store, w).sync_to_staging(p).wait();
+
+        const auto smds = p.staging_mds();
+        for (auto q = 0uz; q < p.size(); ++q) {
+            expect(std::abs(smds[q][0]) < 1e-12);
+            expect(std::abs(smds[q][2]) < 1e-12);
+        }
+    };
+};
+
+} // namespace
+
+int
+main(int argc, const char** argv) {
+    return static_cast<int>(cfg<override>.run(run_cfg{ .argc = argc, .argv = argv }));
+}
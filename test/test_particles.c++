@@ -0,0 +1,112 @@
+#include <boost/ut.hpp> // import boost.ut;
+
+#include <cstddef>
+
+#include "thrust/device_vector.h"
+
+#include "tyvi/mdgrid.h"
+#include "tyvi/mdspan.h"
+#include "tyvi/particles.h"
+#include "tyvi/sstd.h"
+
+namespace {
+using namespace boost::ut;
+
+constexpr auto vec_desc = tyvi::mdgrid_element_descriptor<double>{ .rank = 1, .dim = 3 };
+using vec_particles     = tyvi::particles<vec_desc>;
+
+/// Sets component i of particle p to 10 * p + i.
+void
+fill(vec_particles& p, const tyvi::mdgrid_work& w) {
+    w.for_each_index(p, [m = p.mds()](const auto& idx, const auto& jdx) {
+        m[idx][jdx] = static_cast<double>(10uz * idx[0] + jdx[0]);
+    });
+}
+
+[[maybe_unused]]
+const suite<"particles"> _ = [] {
+    "particles are constructible"_test = [] {
+        const auto p = vec_particles(5);
+        expect(p.size() == 5uz);
+        expect(p.capacity() == 5uz);
+        expect(p.mds().extents().extent(0) == 5uz);
+        expect(vec_particles::num_components == 3uz);
+
+        const auto q = vec_particles{};
+        expect(q.empty());
+    };
+
+    "growth preserves particles and is amortized"_test = [] {
+        const auto w = tyvi::mdgrid_work{};
+        auto p       = vec_particles(4);
+        fill(p, w);
+
+        p.resize(5, w);
+        expect(p.size() == 5uz);
+        expect(p.capacity() == 8uz);
+
+        p.resize(8, w);
+        expect(p.capacity() == 8uz);
+
+        w.sync_to_staging(p).wait();
+        const auto smds = p.staging_mds();
+        for (auto i = 0uz; i < 4uz; ++i) {
+            for (auto j = 0uz; j < 3uz; ++j) {
+                expect(smds[i][j] == static_cast<double>(10uz * i + j));
+            }
+        }
+    };
+
+    "for_each visits only live particles"_test = [] {
+        const auto w = tyvi::mdgrid_work{};
+        auto p       = vec_particles(3);
+        p.reserve(16, w);
+        expect(p.capacity() == 16uz);
+
+        w.for_each(p, [](const auto& M) { M[0] = 1.0; });
+        w.sync_to_staging(p).wait();
+
+        auto sum = 0.0;
+        for (const auto idx : tyvi::sstd::index_space(p.staging_mds())) {
+            sum += p.staging_mds()[idx][0];
+        }
+        expect(sum == 3.0);
+    };
+
+    "remove_if compacts all components in order"_test = [] {
+        const auto w = tyvi::mdgrid_work{};
+        auto p       = vec_particles(10);
+        p.reserve(12, w);
+        fill(p, w);
+
+        // Remove particles with odd index.
+        const auto removed =
+            p.remove_if([](const auto& M) { return static_cast<int>(M[0] / 10.0) % 2 == 1; }, w);
+        expect(removed == 5uz);
+        expect(p.size() == 5uz);
+
+        w.sync_to_staging(p).wait();
+        const auto smds = p.staging_mds();
+        for (auto i = 0uz; i < p.size(); ++i) {
+            for (auto j = 0uz; j < 3uz; ++j) {
+                expect(smds[i][j] == static_cast<double>(20uz * i + j));
+            }
+        }
+
+        p.shrink_to_fit(w);
+        expect(p.capacity() == 5uz);
+    };
+
+    "permute rejects short permutation"_test = [] {
+        const auto w = tyvi::mdgrid_work{};
+        auto p       = vec_particles(4);
+        expect(throws([&] { p.permute(thrust::device_vector<std::size_t>(3), w); }));
+    };
+};
+
+} // namespace
+
+int
+main(int argc, const char** argv) {
+    return static_cast<int>(cfg<override>.run(run_cfg{ .argc = argc, .argv = argv }));
+}
@@ -0,0 +1,69 @@
+#include <boost/ut.hpp> // import boost.ut;
+
+#include <cstddef>
+#include <sstream>
+#include <string>
+
+#include "tyvi/mdgrid.h"
+#include "tyvi/perf_counters.h"
+
+namespace {
+using namespace boost::ut;
+namespace tpc = tyvi::perf_counters;
+
+[[maybe_unused]]
+const suite<"perf_counters"> _ = [] {
+    "mdgrid_work operations are aggregated per label"_test = [] {
+        constexpr auto elem_desc = tyvi::mdgrid_element_descriptor<double>{ .rank = 1, .dim = 3 };
+        using mdg                = tyvi::mdgrid<elem_desc, std::dextents<std::size_t, 3>>;
+
+        auto grid = mdg(16, 16, 16);
+
+        tpc::clear();
+
+        const auto w = tyvi::mdgrid_work{};
+        for (auto i = 0; i < 3; ++i) {
+            w.for_each(grid, [](const auto& M) { M[0] = M[1] + M[2]; }, "axpy");
+        }
+        w.sync_to_staging(grid).wait();
+
+        const auto profiles = tpc::profiles();
+
+        if constexpr (not tpc::enabled) {
+            expect(profiles.empty());
+            return;
+        }
+
+        expect(profiles.size() == 2uz);
+
+        const auto grid_bytes = 16uz * 16uz * 16uz * 3uz * sizeof(double);
+
+        for (const auto& p : profiles) {
+            if (p.label == "axpy") {
+                expect(p.invocations == 3uz);
+                expect(p.bytes == 3uz * grid_bytes);
+            } else {
+                expect(p.label == "sync_to_staging");
+                expect(p.invocations == 1uz);
+                expect(p.bytes == grid_bytes);
+            }
+
+            expect(p.achieved_bandwidth() >= 0.0);
+            if (p.counters_available) { expect(p.ipc() > 0.0); }
+            if (p.tlb_counter_available) { expect(p.dtlb_misses_per_page() >= 0.0); }
+        }
+    };
+
+    "report has a header"_test = [] {
+        auto ss = std::stringstream{};
+        tpc::write_report(ss);
+        expect(ss.str().starts_with("label"));
+    };
+};
+
+} // namespace
+
+int
+main(int argc, const char** argv) {
+    return static_cast<int>(cfg<override>.run(run_cfg{ .argc = argc, .argv = argv }));
+}